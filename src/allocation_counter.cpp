@@ -0,0 +1,49 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+using namespace std;
+
+namespace {
+
+thread_local bool is_counting = false;
+thread_local size_t allocation_count = 0;
+
+} // namespace
+
+// Заменённые глобальные operator new и delete: пока в потоке нет AllocationCounter,
+// счёт стоит одной проверки thread_local флага. Остальные формы new и delete
+// стандартная библиотека выражает через эти.
+void* operator new(size_t size) {
+	if (is_counting) {
+		++allocation_count;
+	}
+	if (void* pointer = malloc(size == 0 ? 1 : size)) {
+		return pointer;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	free(pointer);
+}
+
+AllocationCounter::AllocationCounter()
+: was_counting_(is_counting)
+, start_count_(allocation_count)
+{
+	is_counting = true;
+}
+
+AllocationCounter::~AllocationCounter() {
+	is_counting = was_counting_;
+}
+
+size_t AllocationCounter::GetAllocationCount() const {
+	return allocation_count - start_count_;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+// Считает вызовы глобального operator new в текущем потоке, пока объект жив.
+// Деструктор возвращает прежнее состояние счётчика, даже если проверка бросила
+// исключение; выделения в других потоках не учитываются.
+class AllocationCounter {
+public:
+	AllocationCounter();
+	~AllocationCounter();
+
+	AllocationCounter(const AllocationCounter&) = delete;
+	AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+	size_t GetAllocationCount() const;
+
+private:
+	bool was_counting_;
+	size_t start_count_;
+};
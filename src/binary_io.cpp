@@ -0,0 +1,15 @@
+#include <cstdint>
+#include <string_view>
+
+#include "binary_io.h"
+
+using namespace std;
+
+uint64_t ComputeChecksum(string_view data) {
+	uint64_t hash = 14695981039346656037ull;
+	for (const char c : data) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Запись и чтение двоичных данных в порядке байтов процессора. Значения
+// и массивы тривиально копируемых типов копируются в буфер и из буфера целиком.
+class BinaryWriter {
+public:
+	template <typename T>
+	void Write(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		WriteBytes(&value, sizeof(T));
+	}
+
+	// Размер и элементы массива
+	template <typename T>
+	void WriteVector(const std::vector<T>& values) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		Write<uint64_t>(values.size());
+		WriteBytes(values.data(), values.size() * sizeof(T));
+	}
+
+	void WriteString(std::string_view text) {
+		Write<uint64_t>(text.size());
+		WriteBytes(text.data(), text.size());
+	}
+
+	void WriteBytes(const void* data, size_t size) {
+		const char* bytes = static_cast<const char*>(data);
+		data_.insert(data_.end(), bytes, bytes + size);
+	}
+
+	std::string_view GetData() const {
+		return data_;
+	}
+
+private:
+	std::string data_;
+};
+
+// Читает данные, записанные BinaryWriter; при выходе за конец буфера
+// выбрасывает runtime_error
+class BinaryReader {
+public:
+	explicit BinaryReader(std::string_view data)
+	: data_(data)
+	{
+	}
+
+	template <typename T>
+	T Read() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value;
+		std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	std::vector<T> ReadVector() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const uint64_t size = Read<uint64_t>();
+		if (size > (data_.size() - position_) / sizeof(T)) {
+			throw std::runtime_error("Binary data is truncated");
+		}
+		std::vector<T> values(size);
+		std::memcpy(values.data(), Take(size * sizeof(T)), size * sizeof(T));
+		return values;
+	}
+
+	// Возвращаемая строка ссылается на буфер читателя
+	std::string_view ReadString() {
+		const uint64_t size = Read<uint64_t>();
+		if (size > data_.size() - position_) {
+			throw std::runtime_error("Binary data is truncated");
+		}
+		return {Take(size), size};
+	}
+
+	bool IsEnd() const {
+		return position_ == data_.size();
+	}
+
+private:
+	std::string_view data_;
+	size_t position_ = 0;
+
+	const char* Take(size_t size) {
+		if (size > data_.size() - position_) {
+			throw std::runtime_error("Binary data is truncated");
+		}
+		const char* result = data_.data() + position_;
+		position_ += size;
+		return result;
+	}
+};
+
+// Контрольная сумма FNV-1a
+uint64_t ComputeChecksum(std::string_view data);
@@ -0,0 +1,90 @@
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "concurrent_search_server.h"
+
+using namespace std;
+
+ConcurrentSearchServer::ConcurrentSearchServer(const SearchServer& search_server)
+: active_copy_(make_shared<SearchServer>(search_server))
+, active_release_state_(make_shared<ReleaseState>())
+, standby_(make_shared<SearchServer>(search_server))
+{
+	active_ = Publish(active_copy_, active_release_state_);
+}
+
+ConcurrentSearchServer::Snapshot ConcurrentSearchServer::GetSnapshot() const {
+	return atomic_load(&active_);
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+		const vector<int>& ratings) {
+	Apply([&](SearchServer& search_server) {
+		search_server.AddDocument(document_id, document, status, ratings);
+	});
+}
+
+void ConcurrentSearchServer::AddDocuments(vector<NewDocument>&& documents) {
+	// второй копии индекса нужен свой экземпляр текстов
+	vector<NewDocument> documents_copy = documents;
+	bool is_first = true;
+	Apply([&](SearchServer& search_server) {
+		search_server.AddDocuments(move(is_first ? documents : documents_copy));
+		is_first = false;
+	});
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+	Apply([document_id](SearchServer& search_server) {
+		search_server.RemoveDocument(document_id);
+	});
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const vector<int>& document_ids) {
+	Apply([&document_ids](SearchServer& search_server) {
+		search_server.RemoveDocuments(document_ids);
+	});
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+	return GetSnapshot()->GetDocumentCount();
+}
+
+ConcurrentSearchServer::Snapshot ConcurrentSearchServer::Publish(const shared_ptr<SearchServer>& copy,
+		const shared_ptr<ReleaseState>& release_state) {
+	// снимки делят один счётчик ссылок; удалитель держит копию, а не удаляет её
+	return Snapshot(copy.get(), [copy, release_state](const SearchServer*) {
+		// уведомление под мьютексом: писатель может удалить состояние сразу после пробуждения
+		lock_guard guard(release_state->mutex);
+		release_state->is_released = true;
+		release_state->released.notify_all();
+	});
+}
+
+template <typename Update>
+void ConcurrentSearchServer::Apply(Update update) {
+	lock_guard guard(write_mutex_);
+
+	// если изменение выбросит исключение, опубликованная копия останется прежней
+	update(*standby_);
+	auto release_state = make_shared<ReleaseState>();
+	Snapshot old_snapshot = atomic_exchange(&active_, Publish(standby_, release_state));
+	swap(standby_, active_copy_);
+	swap(release_state, active_release_state_);
+
+	// новые снимки берутся уже из опубликованной копии, поэтому достаточно
+	// дождаться, пока читатели отпустят снимки старой
+	old_snapshot.reset();
+	{
+		unique_lock lock(release_state->mutex);
+		release_state->released.wait(lock, [&release_state] {
+			return release_state->is_released;
+		});
+	}
+	update(*standby_);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Поисковый сервер, который можно читать во время изменения.
+// Хранит две копии индекса (схема left-right): читатели работают с опубликованной
+// копией, писатель применяет изменение к запасной, публикует её и, дождавшись, пока
+// старую копию отпустят все читатели, повторяет изменение на ней.
+// Читатели никогда не ждут писателя и видят согласованный снимок индекса,
+// писатели выполняются по очереди. Индекс занимает вдвое больше памяти.
+class ConcurrentSearchServer {
+public:
+	using Snapshot = std::shared_ptr<const SearchServer>;
+
+	explicit ConcurrentSearchServer(const SearchServer& search_server);
+
+	// Снимок не меняется, пока он жив. Писатель ждёт освобождения снимков
+	// предыдущей версии, поэтому долго хранить снимок не стоит. Поток, который
+	// держит снимок и сам вызывает изменяющий метод, ждёт себя и не вернётся
+	// никогда: снимок нужно отпустить до изменения.
+	Snapshot GetSnapshot() const;
+
+	void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+	void AddDocuments(std::vector<NewDocument>&& documents);
+	void RemoveDocument(int document_id);
+	void RemoveDocuments(const std::vector<int>& document_ids);
+
+	template <typename... Args>
+	decltype(auto) FindTopDocuments(Args&&... args) const {
+		return GetSnapshot()->FindTopDocuments(std::forward<Args>(args)...);
+	}
+
+	int GetDocumentCount() const;
+
+private:
+	// Отмечает, что отпущены все снимки одной публикации копии
+	struct ReleaseState {
+		std::mutex mutex;
+		std::condition_variable released;
+		bool is_released = false;
+	};
+
+	// снимки опубликованной копии; их удалитель будит писателя, когда отпущен последний
+	Snapshot active_;
+	std::shared_ptr<SearchServer> active_copy_;
+	std::shared_ptr<ReleaseState> active_release_state_;
+	std::shared_ptr<SearchServer> standby_;
+	std::mutex write_mutex_;
+
+	static Snapshot Publish(const std::shared_ptr<SearchServer>& copy, const std::shared_ptr<ReleaseState>& release_state);
+
+	// Применяет изменение к обеим копиям, не останавливая читателей
+	template <typename Update>
+	void Apply(Update update);
+};
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document_loader.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+// Куски данных примерно по LOADER_CHUNK_SIZE байт, которые заканчиваются концом строки
+vector<string_view> SplitIntoChunks(string_view data) {
+	vector<string_view> chunks;
+	while (!data.empty()) {
+		size_t end = data.find('\n', min(LOADER_CHUNK_SIZE, data.size()) - 1);
+		end = end == string_view::npos ? data.size() : end + 1;
+		chunks.push_back(data.substr(0, end));
+		data.remove_prefix(end);
+	}
+	return chunks;
+}
+
+// Отрезает от line поле до табуляции; false, если табуляции нет
+bool TakeField(string_view& line, string_view& field) {
+	const size_t tab = line.find('\t');
+	if (tab == string_view::npos) {
+		return false;
+	}
+	field = line.substr(0, tab);
+	line.remove_prefix(tab + 1);
+	return true;
+}
+
+bool ParseInt(string_view text, int& value) {
+	const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+	return error == errc() && end == text.data() + text.size();
+}
+
+bool ParseStatus(string_view text, DocumentStatus& status) {
+	static const pair<string_view, DocumentStatus> STATUS_NAMES[] = {
+		{"ACTUAL"sv, DocumentStatus::ACTUAL},
+		{"IRRELEVANT"sv, DocumentStatus::IRRELEVANT},
+		{"BANNED"sv, DocumentStatus::BANNED},
+		{"REMOVED"sv, DocumentStatus::REMOVED},
+	};
+	for (const auto& [name, named_status] : STATUS_NAMES) {
+		if (text == name) {
+			status = named_status;
+			return true;
+		}
+	}
+	int number;
+	if (!ParseInt(text, number) || number < 0 || number > static_cast<int>(DocumentStatus::REMOVED)) {
+		return false;
+	}
+	status = static_cast<DocumentStatus>(number);
+	return true;
+}
+
+bool ParseRatings(string_view text, vector<int>& ratings) {
+	while (!text.empty()) {
+		const size_t space = min(text.find(' '), text.size());
+		if (space > 0) {
+			int rating;
+			if (!ParseInt(text.substr(0, space), rating)) {
+				return false;
+			}
+			ratings.push_back(rating);
+		}
+		text.remove_prefix(min(space + 1, text.size()));
+	}
+	return true;
+}
+
+// Разбирает строки куска chunk файла data
+vector<NewDocument> ParseChunk(string_view data, string_view chunk) {
+	vector<NewDocument> documents;
+	while (!chunk.empty()) {
+		const size_t line_end = min(chunk.find('\n'), chunk.size());
+		string_view line = chunk.substr(0, line_end);
+		const char* line_begin = chunk.data();
+		chunk.remove_prefix(min(line_end + 1, chunk.size()));
+		if (!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
+		if (line.empty()) {
+			continue;
+		}
+
+		NewDocument document;
+		string_view id;
+		string_view status;
+		string_view ratings;
+		if (!TakeField(line, id) || !TakeField(line, status) || !TakeField(line, ratings)
+				|| !ParseInt(id, document.id) || !ParseStatus(status, document.status)
+				|| !ParseRatings(ratings, document.ratings)) {
+			// номер строки нужен только для сообщения, поэтому считается лишь при ошибке
+			const size_t line_number = count(data.data(), line_begin, '\n') + 1;
+			throw invalid_argument("Invalid document at line "s + to_string(line_number));
+		}
+		document.text = line;
+		documents.push_back(move(document));
+	}
+	return documents;
+}
+
+} // namespace
+
+size_t LoadDocuments(SearchServer& search_server, const string& path) {
+	const MappedFile file(path);
+	const string_view data = file.GetData();
+	const vector<string_view> chunks = SplitIntoChunks(data);
+
+	// разбор следующих кусков идёт в пуле, пока вызывающий поток сливает готовый кусок в индекс
+	deque<future<PreparedDocuments>> in_flight;
+	size_t next_chunk = 0;
+	const auto submit_chunks = [&] {
+		for (; next_chunk < chunks.size() && in_flight.size() < LOADER_MAX_CHUNKS_IN_FLIGHT; ++next_chunk) {
+			in_flight.push_back(ThreadPool::GetDefault().Submit([&search_server, data, chunk = chunks[next_chunk]] {
+				return search_server.PrepareDocuments(ParseChunk(data, chunk));
+			}));
+		}
+	};
+
+	size_t document_count = 0;
+	try {
+		submit_chunks();
+		while (!in_flight.empty()) {
+			auto result = move(in_flight.front());
+			in_flight.pop_front();
+			PreparedDocuments documents = result.get();
+			submit_chunks();
+			document_count += documents.size();
+			search_server.AddDocuments(move(documents));
+		}
+	} catch (...) {
+		// задачи читают отображение файла, поэтому их нужно дождаться до выхода
+		for (auto& result : in_flight) {
+			result.wait();
+		}
+		throw;
+	}
+	return document_count;
+}
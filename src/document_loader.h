@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "search_server.h"
+
+// Примерный размер куска файла, который разбирается одной задачей
+const size_t LOADER_CHUNK_SIZE = 1 << 20;
+// Сколько кусков может быть разобрано заранее, пока индекс занят предыдущим
+const size_t LOADER_MAX_CHUNKS_IN_FLIGHT = 4;
+
+// Загружает документы из файла, по документу на строку: id, статус, рейтинги через
+// пробел и текст, разделённые табуляцией. Статус - имя (ACTUAL, IRRELEVANT, BANNED,
+// REMOVED) или номер; пустые строки пропускаются.
+// Файл отображается в память и делится на куски по границам строк. Куски разбираются
+// и делятся на слова параллельно в пуле потоков, а вызывающий поток по порядку
+// сливает их в индекс; заранее разбирается не больше LOADER_MAX_CHUNKS_IN_FLIGHT
+// кусков, поэтому память не зависит от размера файла.
+// Возвращает число загруженных документов. Для некорректной строки выбрасывается
+// invalid_argument с её номером; куски до неё остаются в индексе.
+size_t LoadDocuments(SearchServer& search_server, const std::string& path);
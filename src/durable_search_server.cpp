@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "binary_io.h"
+#include "durable_search_server.h"
+
+using namespace std;
+
+namespace {
+
+enum class RecordType : uint8_t {
+	ADD_DOCUMENTS = 1,
+	REMOVE_DOCUMENTS = 2,
+};
+
+const string SNAPSHOT_PREFIX = "snapshot-"s;
+const string SNAPSHOT_SUFFIX = ".bin"s;
+
+// Снимок называется по номеру первой записи журнала, которая в него не вошла
+string GetSnapshotPath(const string& directory, uint64_t lsn) {
+	char name[32];
+	snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(lsn));
+	return (filesystem::path(directory) / (SNAPSHOT_PREFIX + name + SNAPSHOT_SUFFIX)).string();
+}
+
+// Номера и пути снимков каталога по возрастанию номеров
+vector<pair<uint64_t, string>> ListSnapshots(const string& directory) {
+	vector<pair<uint64_t, string>> snapshots;
+	for (const auto& entry : filesystem::directory_iterator(directory)) {
+		const string name = entry.path().filename().string();
+		if (name.size() > SNAPSHOT_PREFIX.size() + SNAPSHOT_SUFFIX.size()
+				&& name.compare(0, SNAPSHOT_PREFIX.size(), SNAPSHOT_PREFIX) == 0
+				&& name.compare(name.size() - SNAPSHOT_SUFFIX.size(), SNAPSHOT_SUFFIX.size(), SNAPSHOT_SUFFIX) == 0) {
+			const string number = name.substr(SNAPSHOT_PREFIX.size(),
+					name.size() - SNAPSHOT_PREFIX.size() - SNAPSHOT_SUFFIX.size());
+			snapshots.emplace_back(stoull(number), entry.path().string());
+		}
+	}
+	sort(snapshots.begin(), snapshots.end());
+	return snapshots;
+}
+
+void WriteNewDocument(BinaryWriter& writer, int document_id, string_view document, DocumentStatus status,
+		const vector<int>& ratings) {
+	writer.Write(document_id);
+	writer.Write(status);
+	writer.WriteVector(ratings);
+	writer.WriteString(document);
+}
+
+void ApplyRecord(SearchServer& search_server, string_view record) {
+	BinaryReader reader(record);
+	const RecordType type = reader.Read<RecordType>();
+	vector<NewDocument> documents;
+	vector<int> document_ids;
+	if (type == RecordType::ADD_DOCUMENTS) {
+		documents.resize(reader.Read<uint64_t>());
+		for (NewDocument& document : documents) {
+			document.id = reader.Read<int>();
+			document.status = reader.Read<DocumentStatus>();
+			document.ratings = reader.ReadVector<int>();
+			document.text = reader.ReadString();
+		}
+	} else if (type == RecordType::REMOVE_DOCUMENTS) {
+		document_ids = reader.ReadVector<int>();
+	} else {
+		throw runtime_error("Unknown write-ahead log record type"s);
+	}
+	if (!reader.IsEnd()) {
+		throw runtime_error("Write-ahead log record is corrupted"s);
+	}
+
+	try {
+		if (type == RecordType::ADD_DOCUMENTS) {
+			search_server.AddDocuments(move(documents));
+		} else {
+			search_server.RemoveDocuments(document_ids);
+		}
+	} catch (const invalid_argument&) {
+		// индекс отклонил это изменение и при работе сервера: запись попадает
+		// в журнал раньше, чем индекс её проверяет
+	}
+}
+
+} // namespace
+
+DurableSearchServer::DurableSearchServer(const string& directory, string_view stop_words)
+: DurableSearchServer(directory, Recover(directory, stop_words))
+{
+}
+
+DurableSearchServer::DurableSearchServer(const string& directory, pair<SearchServer, uint64_t>&& recovered)
+: directory_(directory)
+, server_(recovered.first)
+, log_(directory, recovered.second)
+, next_apply_lsn_(recovered.second)
+{
+}
+
+void DurableSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+		const vector<int>& ratings) {
+	BinaryWriter writer;
+	writer.Write(RecordType::ADD_DOCUMENTS);
+	writer.Write<uint64_t>(1);
+	WriteNewDocument(writer, document_id, document, status, ratings);
+	Apply(writer.GetData(), [&] {
+		server_.AddDocument(document_id, document, status, ratings);
+	});
+}
+
+void DurableSearchServer::AddDocuments(vector<NewDocument>&& documents) {
+	BinaryWriter writer;
+	writer.Write(RecordType::ADD_DOCUMENTS);
+	writer.Write<uint64_t>(documents.size());
+	for (const NewDocument& document : documents) {
+		WriteNewDocument(writer, document.id, document.text, document.status, document.ratings);
+	}
+	Apply(writer.GetData(), [&] {
+		server_.AddDocuments(move(documents));
+	});
+}
+
+void DurableSearchServer::RemoveDocument(int document_id) {
+	RemoveDocuments({document_id});
+}
+
+void DurableSearchServer::RemoveDocuments(const vector<int>& document_ids) {
+	BinaryWriter writer;
+	writer.Write(RecordType::REMOVE_DOCUMENTS);
+	writer.WriteVector(document_ids);
+	Apply(writer.GetData(), [&] {
+		server_.RemoveDocuments(document_ids);
+	});
+}
+
+void DurableSearchServer::Checkpoint() {
+	lock_guard guard(write_mutex_);
+	// писателей нет, поэтому записи до lsn уже на диске и все применены к индексу
+	const uint64_t lsn = log_.Rotate();
+	server_.GetSnapshot()->SaveSnapshot(GetSnapshotPath(directory_, lsn));
+	for (const auto& [snapshot_lsn, path] : ListSnapshots(directory_)) {
+		if (snapshot_lsn < lsn) {
+			filesystem::remove(path);
+		}
+	}
+	log_.RemoveSegmentsBefore(lsn);
+}
+
+ConcurrentSearchServer::Snapshot DurableSearchServer::GetSnapshot() const {
+	return server_.GetSnapshot();
+}
+
+int DurableSearchServer::GetDocumentCount() const {
+	return server_.GetDocumentCount();
+}
+
+pair<SearchServer, uint64_t> DurableSearchServer::Recover(const string& directory, string_view stop_words) {
+	filesystem::create_directories(directory);
+	const auto snapshots = ListSnapshots(directory);
+	SearchServer search_server = snapshots.empty()
+			? SearchServer(stop_words)
+			: SearchServer::LoadSnapshot(snapshots.back().second);
+	const uint64_t snapshot_lsn = snapshots.empty() ? 0 : snapshots.back().first;
+
+	const uint64_t next_lsn = WriteAheadLog::Replay(directory, snapshot_lsn,
+			[&search_server](uint64_t, string_view record) {
+		ApplyRecord(search_server, record);
+	});
+	if (snapshots.empty()) {
+		// стоп-слова хранятся только в снимке, поэтому новый каталог сразу получает снимок
+		search_server.SaveSnapshot(GetSnapshotPath(directory, next_lsn));
+	}
+	return {move(search_server), next_lsn};
+}
+
+template <typename Update>
+void DurableSearchServer::Apply(string_view record, Update update) {
+	shared_lock write_guard(write_mutex_);
+	// если запись не удалось сбросить на диск, Sync выбросит исключение до изменения индекса;
+	// после сбоя журнала Sync выбрасывает его и для всех следующих записей
+	const uint64_t lsn = log_.Append(record);
+	log_.Sync(lsn);
+
+	// изменения применяются в порядке записей, как при восстановлении
+	unique_lock lock(apply_mutex_);
+	applied_.wait(lock, [this, lsn] {
+		return next_apply_lsn_ == lsn;
+	});
+	try {
+		update();
+	} catch (...) {
+		++next_apply_lsn_;
+		applied_.notify_all();
+		throw;
+	}
+	++next_apply_lsn_;
+	applied_.notify_all();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "concurrent_search_server.h"
+#include "search_server.h"
+#include "write_ahead_log.h"
+
+// Поисковый сервер, изменения которого переживают сбой процесса. Каталог сервера
+// содержит снимок индекса и журнал упреждающей записи: каждое добавление и удаление
+// сначала записывается в журнал и сбрасывается на диск, и только потом применяется
+// к индексу. Если журнал записать не удалось, метод выбрасывает runtime_error, а
+// индекс не меняется. Одновременные писатели делят один fsync (групповая фиксация)
+// и применяют изменения в порядке номеров записей; пакетные методы пишут одну
+// запись на пакет. Изменение, которое индекс отклонил (например, повтор id), уже
+// есть в журнале и так же пропускается при восстановлении.
+// При открытии загружается последний снимок и к нему применяется хвост журнала.
+// Checkpoint сохраняет новый снимок и удаляет покрытую им часть журнала.
+// Поиск идёт по ConcurrentSearchServer и не ждёт писателей.
+class DurableSearchServer {
+public:
+	// Открывает каталог и восстанавливает индекс; для пустого каталога создаёт индекс
+	// со стоп-словами stop_words, иначе стоп-слова берутся из снимка. Для повреждённых
+	// снимка и журнала выбрасывается runtime_error.
+	explicit DurableSearchServer(const std::string& directory, std::string_view stop_words = {});
+
+	void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+	void AddDocuments(std::vector<NewDocument>&& documents);
+	void RemoveDocument(int document_id);
+	void RemoveDocuments(const std::vector<int>& document_ids);
+
+	// Сохраняет снимок индекса и удаляет журнал до него; писатели на это время останавливаются
+	void Checkpoint();
+
+	ConcurrentSearchServer::Snapshot GetSnapshot() const;
+
+	template <typename... Args>
+	decltype(auto) FindTopDocuments(Args&&... args) const {
+		return server_.FindTopDocuments(std::forward<Args>(args)...);
+	}
+
+	int GetDocumentCount() const;
+
+private:
+	std::string directory_;
+	ConcurrentSearchServer server_;
+	WriteAheadLog log_;
+	// писатели держат мьютекс совместно, Checkpoint - монопольно
+	std::shared_mutex write_mutex_;
+	// номер записи журнала, изменение которой применяется к индексу следующим
+	uint64_t next_apply_lsn_;
+	std::mutex apply_mutex_;
+	std::condition_variable applied_;
+
+	DurableSearchServer(const std::string& directory, std::pair<SearchServer, uint64_t>&& recovered);
+
+	// Загружает последний снимок и применяет к нему журнал; возвращает индекс и номер следующей записи
+	static std::pair<SearchServer, uint64_t> Recover(const std::string& directory, std::string_view stop_words);
+
+	// Записывает record в журнал, ждёт сброса на диск и применяет update к индексу
+	template <typename Update>
+	void Apply(std::string_view record, Update update);
+};
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FILE_IO_HAS_FSYNC
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "file_io.h"
+
+using namespace std;
+
+AppendOnlyFile::AppendOnlyFile(const string& path, bool truncate)
+: path_(path)
+, file_(fopen(path.c_str(), truncate ? "wb" : "ab"))
+{
+	if (file_ == nullptr) {
+		throw runtime_error("Failed to open file "s + path);
+	}
+}
+
+AppendOnlyFile::~AppendOnlyFile() {
+	fclose(file_);
+}
+
+void AppendOnlyFile::Append(string_view data) {
+	if (fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+		throw runtime_error("Failed to write file "s + path_);
+	}
+}
+
+void AppendOnlyFile::Sync() {
+	if (fflush(file_) != 0) {
+		throw runtime_error("Failed to write file "s + path_);
+	}
+#ifdef FILE_IO_HAS_FSYNC
+	if (fsync(fileno(file_)) != 0) {
+		throw runtime_error("Failed to sync file "s + path_);
+	}
+#endif
+}
+
+void WriteFileAtomically(const string& path, string_view header, string_view payload) {
+	const string temporary_path = path + ".tmp"s;
+	{
+		AppendOnlyFile output(temporary_path, true);
+		output.Append(header);
+		output.Append(payload);
+		// без этого после сбоя системы переименованный файл может оказаться пустым
+		output.Sync();
+	}
+	filesystem::rename(temporary_path, path);
+	SyncDirectory(filesystem::path(path).parent_path().string());
+}
+
+void SyncDirectory([[maybe_unused]] const string& path) {
+#ifdef FILE_IO_HAS_FSYNC
+	const int fd = open(path.empty() ? "." : path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error("Failed to open directory "s + path);
+	}
+	const int result = fsync(fd);
+	close(fd);
+	if (result != 0) {
+		throw runtime_error("Failed to sync directory "s + path);
+	}
+#endif
+}
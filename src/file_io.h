@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Файл, открытый на дозапись. Sync сбрасывает записанное на диск, после чего
+// данные переживают сбой процесса и системы. Ошибки ввода-вывода - runtime_error.
+class AppendOnlyFile {
+public:
+	// Если truncate, существующее содержимое файла удаляется
+	AppendOnlyFile(const std::string& path, bool truncate);
+
+	AppendOnlyFile(const AppendOnlyFile&) = delete;
+	AppendOnlyFile& operator=(const AppendOnlyFile&) = delete;
+	~AppendOnlyFile();
+
+	void Append(std::string_view data);
+	void Sync();
+
+private:
+	std::string path_;
+	std::FILE* file_;
+};
+
+// Записывает header и payload во временный файл, сбрасывает его на диск и
+// переименовывает в path, поэтому сбой при записи не портит прежний файл
+void WriteFileAtomically(const std::string& path, std::string_view header, std::string_view payload);
+
+// Сбрасывает на диск записи каталога о созданных, переименованных и удалённых файлах
+void SyncDirectory(const std::string& path);
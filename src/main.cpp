@@ -1,9 +1,17 @@
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "document_loader.h"
+#include "durable_search_server.h"
 #include "log_duration.h"
+#include "mapped_search_server.h"
 #include "paginator.h"
 #include "print_functions.h"
 #include "process_queries.h"
@@ -12,6 +20,7 @@
 #include "request_queue.h"
 #include "test_example_functions.h"
 #include "search_server.h"
+#include "tokenizer.h"
 
 
 
@@ -61,14 +70,48 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
     return queries;
 }
 
-template <typename QueriesProcessor>
-void TestProcessQueries(string_view mark, QueriesProcessor processor, const SearchServer& search_server, const vector<string>& queries) {
+// Запросы из слов, частоты которых убывают по закону Ципфа: первое слово словаря самое частое
+vector<string> GenerateZipfQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int word_count) {
+    vector<double> weights;
+    weights.reserve(dictionary.size());
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        string query;
+        for (int j = 0; j < word_count; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            query += dictionary[word_distribution(generator)];
+        }
+        queries.push_back(move(query));
+    }
+    return queries;
+}
+
+// Каждый запрос выполняется отдельно, для сравнения с пакетным ProcessQueries
+vector<vector<Document>> ProcessQueriesUnbatched(const SearchServer& search_server, const vector<string>& queries) {
+	vector<vector<Document>> result(queries.size());
+	ThreadPool::GetDefault().ParallelFor(queries.size(), [&](size_t index) {
+		result[index] = search_server.FindTopDocuments(queries[index]);
+	});
+	return result;
+}
+
+template <typename QueriesProcessor, typename SearchServerType>
+void TestProcessQueries(string_view mark, QueriesProcessor processor, const SearchServerType& search_server, const vector<string>& queries) {
 	LOG_DURATION(mark);
 	const auto documents = processor(search_server, queries);
 	cout << documents.size() << endl;
 }
 
-#define TEST_PROCESS_QUERIES(processor) TestProcessQueries(#processor, processor, search_server, queries)
+#define TEST_PROCESS_QUERIES(processor) TestProcessQueries(#processor, \
+		[](const SearchServer& server, const vector<string>& queries) { return processor(server, queries); }, \
+		search_server, queries)
 
 template <typename ExecutionPolicy>
 void TestRemoveDocument(string_view mark, SearchServer search_server, ExecutionPolicy&& policy) {
@@ -81,13 +124,225 @@ void TestRemoveDocument(string_view mark, SearchServer search_server, ExecutionP
 }
 #define TEST_REMOVE_DOCUMENT(mode) TestRemoveDocument(#mode, search_server, execution::mode)
 
+void TestAddDocument(string_view mark, const string& stop_words, const vector<string>& documents) {
+	SearchServer search_server(stop_words);
+	LOG_DURATION(mark);
+	for (size_t i = 0; i < documents.size(); ++i) {
+		search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+	}
+	cout << search_server.GetDocumentCount() << endl;
+}
+
+SearchServer TestAddDocuments(string_view mark, const string& stop_words, const vector<string>& documents) {
+	vector<NewDocument> new_documents;
+	new_documents.reserve(documents.size());
+	for (size_t i = 0; i < documents.size(); ++i) {
+		new_documents.push_back({static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+	}
+
+	SearchServer search_server(stop_words);
+	{
+		LOG_DURATION(mark);
+		search_server.AddDocuments(move(new_documents));
+		cout << search_server.GetDocumentCount() << endl;
+	}
+	return search_server;
+}
+
+// Загрузка файла построчно через getline против LoadDocuments
+void TestLoadDocuments(const string& stop_words, const vector<string>& documents) {
+	const string path = (filesystem::temp_directory_path() / "search_server_benchmark.tsv"s).string();
+	{
+		ofstream output(path, ios::binary | ios::trunc);
+		for (size_t i = 0; i < documents.size(); ++i) {
+			output << i << "\t0\t1 2 3\t"s << documents[i] << '\n';
+		}
+	}
+	{
+		SearchServer search_server(stop_words);
+		LOG_DURATION("getline + AddDocument"sv);
+		ifstream input(path, ios::binary);
+		string line;
+		while (getline(input, line)) {
+			const size_t status_begin = line.find('\t') + 1;
+			const size_t ratings_begin = line.find('\t', status_begin) + 1;
+			const size_t text_begin = line.find('\t', ratings_begin) + 1;
+			istringstream ratings_input(line.substr(ratings_begin, text_begin - 1 - ratings_begin));
+			vector<int> ratings;
+			for (int rating; ratings_input >> rating;) {
+				ratings.push_back(rating);
+			}
+			search_server.AddDocument(stoi(line.substr(0, status_begin - 1)), line.substr(text_begin),
+					static_cast<DocumentStatus>(stoi(line.substr(status_begin))), ratings);
+		}
+		cout << search_server.GetDocumentCount() << endl;
+	}
+	{
+		SearchServer search_server(stop_words);
+		LOG_DURATION("LoadDocuments"sv);
+		cout << LoadDocuments(search_server, path) << endl;
+	}
+	filesystem::remove(path);
+}
+
+// Добавление с журналом: каждый вызов ждёт fsync, одновременные писатели делят его
+void TestDurableAddDocument(string_view mark, const string& stop_words, const vector<string>& documents,
+		int writer_count) {
+	const auto directory = filesystem::temp_directory_path() / "search_server_benchmark_wal"s;
+	filesystem::remove_all(directory);
+	{
+		DurableSearchServer search_server(directory.string(), stop_words);
+		LOG_DURATION(mark);
+		vector<thread> writers;
+		for (int writer_index = 0; writer_index < writer_count; ++writer_index) {
+			writers.emplace_back([&, writer_index] {
+				for (size_t i = writer_index; i < documents.size(); i += writer_count) {
+					search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+				}
+			});
+		}
+		for (thread& writer : writers) {
+			writer.join();
+		}
+		cout << search_server.GetDocumentCount() << endl;
+	}
+	filesystem::remove_all(directory);
+}
+
+void TestDurableAddDocuments(string_view mark, const string& stop_words, const vector<string>& documents) {
+	vector<NewDocument> new_documents;
+	new_documents.reserve(documents.size());
+	for (size_t i = 0; i < documents.size(); ++i) {
+		new_documents.push_back({static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+	}
+	const auto directory = filesystem::temp_directory_path() / "search_server_benchmark_wal"s;
+	filesystem::remove_all(directory);
+	{
+		DurableSearchServer search_server(directory.string(), stop_words);
+		LOG_DURATION(mark);
+		search_server.AddDocuments(move(new_documents));
+		cout << search_server.GetDocumentCount() << endl;
+	}
+	filesystem::remove_all(directory);
+}
+
+void TestTokenizeWords(string_view mark, const vector<string>& documents, TokenizerLevel level) {
+	LOG_DURATION(mark);
+	vector<string_view> words;
+	size_t word_count = 0;
+	for (int repeat = 0; repeat < 10; ++repeat) {
+		for (const string& document : documents) {
+			words.clear();
+			TokenizeWords(document, words, level);
+			word_count += words.size();
+		}
+	}
+	cout << word_count << endl;
+}
+
+// Байты, выделенные контейнерами с CountingAllocator
+size_t counted_bytes = 0;
+
+template <typename T>
+struct CountingAllocator {
+	using value_type = T;
+
+	CountingAllocator() = default;
+	template <typename U>
+	CountingAllocator(const CountingAllocator<U>&) {
+	}
+
+	T* allocate(size_t count) {
+		counted_bytes += count * sizeof(T);
+		return allocator<T>().allocate(count);
+	}
+	void deallocate(T* pointer, size_t count) {
+		counted_bytes -= count * sizeof(T);
+		allocator<T>().deallocate(pointer, count);
+	}
+
+	template <typename U>
+	bool operator==(const CountingAllocator<U>&) const {
+		return true;
+	}
+	template <typename U>
+	bool operator!=(const CountingAllocator<U>&) const {
+		return false;
+	}
+};
+
+// Память списков вхождений против прежнего индекса map<int, double> на слово;
+// для map считаются только узлы, без накладных расходов malloc
+void TestPostingsMemory(const SearchServer& search_server) {
+	using MapPostings = map<int, double, less<int>, CountingAllocator<pair<const int, double>>>;
+	counted_bytes = 0;
+	map<string_view, MapPostings> map_index;
+	for (const int document_id : search_server) {
+		for (const auto& [word, term_freq] : search_server.GetWordFrequencies(document_id)) {
+			map_index[word].emplace(document_id, term_freq);
+		}
+	}
+	cout << "Postings memory: map<int, double> "s << counted_bytes / 1024 << " KiB, blocks "s
+			<< search_server.GetPostingsMemoryUsage() / 1024 << " KiB"s << endl;
+}
+
+void TestSnapshot(const SearchServer& search_server) {
+	const string path = (filesystem::temp_directory_path() / "search_server_benchmark.snapshot"s).string();
+	{
+		LOG_DURATION("SaveSnapshot"sv);
+		search_server.SaveSnapshot(path);
+	}
+	{
+		LOG_DURATION("LoadSnapshot"sv);
+		cout << SearchServer::LoadSnapshot(path).GetDocumentCount() << endl;
+	}
+	filesystem::remove(path);
+}
+
+template <typename Server>
+void TestFindTopDocuments(string_view mark, const Server& server, const vector<string>& queries) {
+	LOG_DURATION(mark);
+	size_t document_count = 0;
+	for (const string& query : queries) {
+		document_count += server.FindTopDocuments(query).size();
+	}
+	cout << document_count << endl;
+}
+
+void TestMappedIndex(const SearchServer& search_server, const vector<string>& queries) {
+	const string path = (filesystem::temp_directory_path() / "search_server_benchmark.index"s).string();
+	{
+		LOG_DURATION("SaveMappedIndex"sv);
+		search_server.SaveMappedIndex(path);
+	}
+	{
+		// открытие не читает индекс, поэтому первые запросы подгружают страницы
+		const MappedSearchServer mapped_server = [&path] {
+			LOG_DURATION("MappedSearchServer open"sv);
+			return MappedSearchServer(path);
+		}();
+		TestFindTopDocuments("FindTopDocuments in memory"sv, search_server, queries);
+		TestFindTopDocuments("FindTopDocuments mapped"sv, mapped_server, queries);
+	}
+	filesystem::remove(path);
+}
+
+void TestRemoveDocuments(string_view mark, SearchServer search_server) {
+	LOG_DURATION(mark);
+	vector<int> document_ids(search_server.begin(), search_server.end());
+	search_server.RemoveDocuments(document_ids);
+	cout << search_server.GetDocumentCount() << endl;
+}
+
 template <typename ExecutionPolicy>
-void TestMatchDocument(string_view mark, SearchServer search_server, const string& query, ExecutionPolicy&& policy) {
+void TestMatchDocument(string_view mark, const SearchServer& search_server, const string& query, ExecutionPolicy&& policy) {
 	LOG_DURATION(mark);
+	// запрос разбирается один раз на все документы
+	const PreparedQuery prepared_query = search_server.PrepareQuery(query);
 	const int document_count = search_server.GetDocumentCount();
 	int word_count = 0;
 	for (int id = 0; id < document_count; ++id) {
-		const auto [words, status] = search_server.MatchDocument(policy, query, id);
+		const auto [words, status] = search_server.MatchDocument(policy, prepared_query, id);
 		word_count += words.size();
 	}
 	cout << word_count << endl;
@@ -95,6 +350,27 @@ void TestMatchDocument(string_view mark, SearchServer search_server, const strin
 
 #define TEST_MATCH_DOCUMENTS(policy) TestMatchDocument(#policy, search_server, query, execution::policy)
 
+void TestMatchDocumentRaw(string_view mark, const SearchServer& search_server, const string& query) {
+	LOG_DURATION(mark);
+	const int document_count = search_server.GetDocumentCount();
+	int word_count = 0;
+	for (int id = 0; id < document_count; ++id) {
+		const auto [words, status] = search_server.MatchDocument(query, id);
+		word_count += words.size();
+	}
+	cout << word_count << endl;
+}
+
+void TestMatchDocuments(string_view mark, const SearchServer& search_server, const string& query) {
+	LOG_DURATION(mark);
+	const vector<int> document_ids(search_server.begin(), search_server.end());
+	int word_count = 0;
+	for (const auto& [words, status] : search_server.MatchDocuments(search_server.PrepareQuery(query), document_ids)) {
+		word_count += words.size();
+	}
+	cout << word_count << endl;
+}
+
 template <typename ExecutionPolicy>
 void TestFindTopDocuments(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
 	LOG_DURATION(mark);
@@ -117,13 +393,38 @@ int main() {
 		const auto dictionary = GenerateDictionary(generator, 10000, 25);
 		const auto documents = GenerateQueries(generator, dictionary, 100'000, 10);
 
-		SearchServer search_server(dictionary[0]);
-		for (size_t i = 0; i < documents.size(); ++i) {
-			search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+		TestTokenizeWords("TokenizeWords scalar"sv, documents, TokenizerLevel::SCALAR);
+		if (GetSupportedTokenizerLevel() != TokenizerLevel::SCALAR) {
+			TestTokenizeWords("TokenizeWords SSE2"sv, documents, TokenizerLevel::SSE2);
+		}
+		if (GetSupportedTokenizerLevel() == TokenizerLevel::AVX2) {
+			TestTokenizeWords("TokenizeWords AVX2"sv, documents, TokenizerLevel::AVX2);
 		}
+		TestAddDocument("AddDocument"sv, dictionary[0], documents);
+		const SearchServer search_server = TestAddDocuments("AddDocuments"sv, dictionary[0], documents);
+		TestPostingsMemory(search_server);
+		TestSnapshot(search_server);
+		TestLoadDocuments(dictionary[0], documents);
+
+		TestDurableAddDocuments("AddDocuments with WAL"sv, dictionary[0], documents);
+		const vector<string> wal_documents(documents.begin(), documents.begin() + 10'000);
+		TestAddDocument("AddDocument in memory"sv, dictionary[0], wal_documents);
+		TestDurableAddDocument("AddDocument with WAL, 1 writer"sv, dictionary[0], wal_documents, 1);
+		TestDurableAddDocument("AddDocument with WAL, 4 writers"sv, dictionary[0], wal_documents, 4);
 
 		const auto queries = GenerateQueries(generator, dictionary, 10'000, 7);
 		TEST_PROCESS_QUERIES(ProcessQueries);
+		TestMappedIndex(search_server, queries);
+
+		ShardedSearchServer sharded_server{SearchServer{dictionary[0]}, 4};
+		vector<NewDocument> new_documents;
+		for (size_t i = 0; i < documents.size(); ++i) {
+			new_documents.push_back({static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+		}
+		sharded_server.AddDocuments(move(new_documents));
+		TestProcessQueries("ProcessQueries sharded"sv,
+				[](const ShardedSearchServer& server, const vector<string>& queries) { return ProcessQueries(server, queries); },
+				sharded_server, queries);
 	}
 
 	{
@@ -139,6 +440,7 @@ int main() {
 
 		TEST_REMOVE_DOCUMENT(seq);
 		TEST_REMOVE_DOCUMENT(par);
+		TestRemoveDocuments("batch"sv, search_server);
 	}
 
 	{
@@ -154,8 +456,10 @@ int main() {
 			search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
 		}
 
+		TestMatchDocumentRaw("seq, raw query"sv, search_server, query);
 		TEST_MATCH_DOCUMENTS(seq);
 		TEST_MATCH_DOCUMENTS(par);
+		TestMatchDocuments("MatchDocuments"sv, search_server, query);
 	}
 
 	{
@@ -173,6 +477,57 @@ int main() {
 
 		TEST_FIND_TOP_DOCUMENTS(seq);
 		TEST_FIND_TOP_DOCUMENTS(par);
+		TestFindTopDocuments("block_max_wand"sv, search_server, queries, block_max_wand);
+
+		// пакетный ProcessQueries против независимых запросов в том же пуле потоков
+		TEST_PROCESS_QUERIES(ProcessQueriesUnbatched);
+		TEST_PROCESS_QUERIES(ProcessQueries);
+	}
+
+	{
+		mt19937 generator;
+
+		// запросы по словам разной частоты: block_max_wand не перебирает документы,
+		// в которых есть только частые слова запроса, ни для коротких, ни для длинных запросов
+		const auto dictionary = GenerateDictionary(generator, 10000, 10);
+		const auto documents = GenerateZipfQueries(generator, dictionary, 50'000, 30);
+
+		SearchServer search_server(dictionary[0]);
+		for (size_t i = 0; i < documents.size(); ++i) {
+			search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+		}
+
+		const auto queries = GenerateZipfQueries(generator, dictionary, 300, 3);
+
+		TEST_FIND_TOP_DOCUMENTS(seq);
+		TestFindTopDocuments("block_max_wand"sv, search_server, queries, block_max_wand);
+
+		const auto long_queries = GenerateZipfQueries(generator, dictionary, 300, 24);
+
+		TestFindTopDocuments("seq, 24 words"sv, search_server, long_queries, execution::seq);
+		TestFindTopDocuments("block_max_wand, 24 words"sv, search_server, long_queries, block_max_wand);
+	}
+
+	{
+		mt19937 generator;
+
+		// однословные запросы по частым словам: распараллеливаются только делением документов
+		const auto dictionary = GenerateDictionary(generator, 100, 10);
+		const auto documents = GenerateQueries(generator, dictionary, 100'000, 20);
+
+		SearchServer search_server(dictionary[0]);
+		for (size_t i = 0; i < documents.size(); ++i) {
+			search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+		}
+
+		const auto queries = GenerateQueries(generator, dictionary, 100, 1);
+
+		TEST_FIND_TOP_DOCUMENTS(seq);
+		TEST_FIND_TOP_DOCUMENTS(par);
+
+		// пакетный ProcessQueries против независимых запросов в том же пуле потоков
+		TEST_PROCESS_QUERIES(ProcessQueriesUnbatched);
+		TEST_PROCESS_QUERIES(ProcessQueries);
 	}
 
 	cout << "Done" << endl;
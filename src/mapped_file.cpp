@@ -0,0 +1,83 @@
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) {
+#ifdef MAPPED_FILE_HAS_MMAP
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw runtime_error("Failed to open file "s + path);
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0) {
+		close(fd);
+		throw runtime_error("Failed to stat file "s + path);
+	}
+	size_ = static_cast<size_t>(file_stat.st_size);
+	if (size_ > 0) {
+		void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			throw runtime_error("Failed to map file "s + path);
+		}
+		data_ = static_cast<const char*>(data);
+	}
+	// отображение остаётся действительным и после закрытия дескриптора
+	close(fd);
+#else
+	ifstream input(path, ios::binary);
+	if (!input) {
+		throw runtime_error("Failed to open file "s + path);
+	}
+	buffer_.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		Unmap();
+		const bool is_buffered = other.data_ == other.buffer_.data();
+		buffer_ = move(other.buffer_);
+		// при переносе короткой строки её данные меняют адрес
+		data_ = is_buffered ? buffer_.data() : other.data_;
+		size_ = other.size_;
+		other.data_ = nullptr;
+		other.size_ = 0;
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	Unmap();
+}
+
+void MappedFile::Unmap() {
+#ifdef MAPPED_FILE_HAS_MMAP
+	if (data_ != nullptr && data_ != buffer_.data()) {
+		munmap(const_cast<char*>(data_), size_);
+	}
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	buffer_.clear();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Файл, отображённый в память только для чтения. Страницы подгружаются по
+// обращению и делятся между процессами, отобразившими тот же файл. Где
+// отображение недоступно, файл читается в память целиком.
+class MappedFile {
+public:
+	// Для отсутствующего или нечитаемого файла выбрасывает runtime_error
+	explicit MappedFile(const std::string& path);
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	std::string_view GetData() const {
+		return {data_, size_};
+	}
+
+private:
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+	// содержимое файла, если отображение недоступно
+	std::string buffer_;
+
+	void Unmap();
+};
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "mapped_search_server.h"
+#include "string_processing.h"
+
+using namespace std;
+
+namespace {
+
+void CheckMappedIndex(bool condition) {
+	if (!condition) {
+		throw runtime_error("Mapped index is corrupted"s);
+	}
+}
+
+} // namespace
+
+MappedSearchServer::MappedSearchServer(const string& path)
+: file_(path)
+{
+	const string_view data = file_.GetData();
+	if (data.size() < sizeof(MappedIndexHeader)
+			|| memcmp(data.data(), MAPPED_INDEX_MAGIC, sizeof(MAPPED_INDEX_MAGIC)) != 0) {
+		throw runtime_error("File "s + path + " is not a mapped search index"s);
+	}
+	header_ = reinterpret_cast<const MappedIndexHeader*>(data.data());
+	if (header_->format_version != MAPPED_INDEX_FORMAT_VERSION) {
+		throw runtime_error("Unsupported mapped index format version "s + to_string(header_->format_version));
+	}
+	CheckMappedIndex(header_->file_size == data.size());
+	CheckMappedIndex(header_->document_count < PostingList::NO_ORDINAL && header_->term_count < NO_TERM
+			&& header_->stop_word_count < data.size());
+
+	// проверяются только заголовок и границы секций, поэтому открытие не зависит от размера индекса
+	const auto get_section = [&data](const MappedIndexSection& section, uint64_t element_size) {
+		CheckMappedIndex(section.offset % MAPPED_INDEX_ALIGNMENT == 0 && section.offset <= data.size()
+				&& section.size <= data.size() - section.offset && section.size % element_size == 0);
+		return data.data() + section.offset;
+	};
+	const auto get_array = [&get_section](const MappedIndexSection& section, uint64_t element_size,
+			uint64_t element_count) {
+		CheckMappedIndex(section.size / element_size == element_count);
+		return get_section(section, element_size);
+	};
+	const uint64_t document_count = header_->document_count;
+	const uint64_t term_count = header_->term_count;
+	const auto* stop_word_offsets = reinterpret_cast<const uint64_t*>(
+			get_array(header_->stop_word_offsets, sizeof(uint64_t), header_->stop_word_count + 1));
+	const char* stop_word_chars = get_section(header_->stop_word_chars, 1);
+	term_offsets_ = reinterpret_cast<const uint64_t*>(get_array(header_->term_offsets, sizeof(uint64_t), term_count + 1));
+	term_chars_ = get_section(header_->term_chars, 1);
+	terms_ = reinterpret_cast<const MappedIndexTerm*>(get_array(header_->terms, sizeof(MappedIndexTerm), term_count));
+	blocks_ = reinterpret_cast<const PostingList::Block*>(get_section(header_->blocks, sizeof(PostingList::Block)));
+	posting_data_ = reinterpret_cast<const uint8_t*>(get_section(header_->posting_data, 1));
+	document_ids_ = reinterpret_cast<const int32_t*>(get_array(header_->document_ids, sizeof(int32_t), document_count));
+	ratings_ = reinterpret_cast<const int32_t*>(get_array(header_->ratings, sizeof(int32_t), document_count));
+	statuses_ = reinterpret_cast<const uint8_t*>(get_array(header_->statuses, 1, document_count));
+	inv_word_counts_ = reinterpret_cast<const double*>(
+			get_array(header_->inv_word_counts, sizeof(double), document_count));
+	id_to_ordinal_ = reinterpret_cast<const MappedIndexDocumentId*>(
+			get_array(header_->id_to_ordinal, sizeof(MappedIndexDocumentId), document_count));
+
+	for (uint64_t i = 0; i < header_->stop_word_count; ++i) {
+		CheckMappedIndex(stop_word_offsets[i] <= stop_word_offsets[i + 1]
+				&& stop_word_offsets[i + 1] <= header_->stop_word_chars.size);
+		stop_words_.emplace(stop_word_chars + stop_word_offsets[i], stop_word_offsets[i + 1] - stop_word_offsets[i]);
+	}
+}
+
+vector<Document> MappedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status,
+		size_t max_document_count) const {
+	return FindTopDocuments(raw_query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, max_document_count);
+}
+
+tuple<vector<string_view>, DocumentStatus> MappedSearchServer::MatchDocument(string_view raw_query,
+		int document_id) const {
+	const uint32_t ordinal = FindOrdinal(document_id);
+	if (ordinal == PostingList::NO_ORDINAL) {
+		throw out_of_range("No documents with id "s + to_string(document_id));
+	}
+	const DocumentStatus status = static_cast<DocumentStatus>(statuses_[ordinal]);
+	const Query query = ParseQuery(raw_query);
+
+	// возвращаемые string_view ссылаются на отображённый файл
+	vector<string_view> matched_words;
+	for (const QueryTerm& term : query.minus_terms) {
+		if (term.term_index != NO_TERM && Contains(term.term_index, ordinal)) {
+			return make_tuple(matched_words, status);
+		}
+	}
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_index != NO_TERM && Contains(term.term_index, ordinal)) {
+			matched_words.push_back(GetTerm(term.term_index));
+		}
+	}
+	return make_tuple(matched_words, status);
+}
+
+int MappedSearchServer::GetDocumentCount() const {
+	return static_cast<int>(header_->document_count);
+}
+
+bool MappedSearchServer::HasDocument(int document_id) const {
+	return FindOrdinal(document_id) != PostingList::NO_ORDINAL;
+}
+
+MappedSearchServer::Query MappedSearchServer::ParseQuery(string_view text) const {
+	Query result;
+	ForEachWordView(text, [this, &result](string_view word) {
+		const auto query_word = ParseQueryWord(word);
+		if (stop_words_.count(query_word.data) == 0) {
+			auto& terms = query_word.is_minus ? result.minus_terms : result.plus_terms;
+			terms.push_back({query_word.data, NO_TERM});
+		}
+	});
+	for (auto* terms : {&result.plus_terms, &result.minus_terms}) {
+		sort(terms->begin(), terms->end(), [](const QueryTerm& lhs, const QueryTerm& rhs) {
+			return lhs.word < rhs.word;
+		});
+		terms->erase(unique(terms->begin(), terms->end(), [](const QueryTerm& lhs, const QueryTerm& rhs) {
+			return lhs.word == rhs.word;
+		}), terms->end());
+		for (QueryTerm& term : *terms) {
+			term.term_index = FindTerm(term.word);
+		}
+	}
+	return result;
+}
+
+uint32_t MappedSearchServer::FindTerm(string_view word) const {
+	// слова лежат по возрастанию, поэтому словарь - двоичный поиск по отображённому массиву
+	uint32_t first = 0;
+	uint32_t last = static_cast<uint32_t>(header_->term_count);
+	while (first < last) {
+		const uint32_t middle = first + (last - first) / 2;
+		if (GetTerm(middle) < word) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	return first < header_->term_count && GetTerm(first) == word ? first : NO_TERM;
+}
+
+string_view MappedSearchServer::GetTerm(uint32_t term_index) const {
+	const uint64_t begin = term_offsets_[term_index];
+	const uint64_t end = term_offsets_[term_index + 1];
+	CheckMappedIndex(begin <= end && end <= header_->term_chars.size);
+	return {term_chars_ + begin, end - begin};
+}
+
+const MappedIndexTerm& MappedSearchServer::GetPostings(uint32_t term_index) const {
+	const MappedIndexTerm& term = terms_[term_index];
+	const uint64_t block_count = header_->blocks.size / sizeof(PostingList::Block);
+	const uint64_t data_size = header_->posting_data.size;
+	CheckMappedIndex(term.document_count > 0
+			&& term.first_block <= block_count && term.block_count <= block_count - term.first_block
+			&& term.data_offset <= data_size && term.data_size <= data_size - term.data_offset);
+	return term;
+}
+
+uint32_t MappedSearchServer::FindOrdinal(int document_id) const {
+	const MappedIndexDocumentId* end = id_to_ordinal_ + header_->document_count;
+	const auto it = lower_bound(id_to_ordinal_, end, document_id,
+			[](const MappedIndexDocumentId& entry, int document_id) {
+		return entry.document_id < document_id;
+	});
+	if (it == end || it->document_id != document_id) {
+		return PostingList::NO_ORDINAL;
+	}
+	CheckMappedIndex(it->ordinal < header_->document_count);
+	return it->ordinal;
+}
+
+bool MappedSearchServer::Contains(uint32_t term_index, uint32_t ordinal) const {
+	const MappedIndexTerm& term = GetPostings(term_index);
+	const PostingList::Block* begin = blocks_ + term.first_block;
+	const PostingList::Block* end = begin + term.block_count;
+	// первый блок, последний документ которого не меньше ordinal
+	const auto block = lower_bound(begin, end, ordinal, [](const PostingList::Block& block, uint32_t ordinal) {
+		return block.last_ordinal < ordinal;
+	});
+	if (block == end || block->first_ordinal > ordinal) {
+		return false;
+	}
+	CheckBlock(*block, term);
+	array<Posting, PostingList::BLOCK_SIZE> postings;
+	const size_t count = PostingList::DecodeBlock(*block, posting_data_ + term.data_offset, postings.data());
+	return binary_search(postings.begin(), postings.begin() + count, Posting{ordinal, 0},
+			[](const Posting& lhs, const Posting& rhs) {
+		return lhs.ordinal < rhs.ordinal;
+	});
+}
+
+void MappedSearchServer::CheckBlock(const PostingList::Block& block, const MappedIndexTerm& term) {
+	CheckMappedIndex(block.offset < term.data_size && block.count > 0 && block.count <= PostingList::BLOCK_SIZE);
+}
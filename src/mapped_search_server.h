@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "mapped_file.h"
+#include "posting_list.h"
+#include "score_accumulator.h"
+#include "search_server.h"
+#include "small_vector.h"
+#include "top_documents_collector.h"
+
+// Версия формата отображаемого индекса; меняется при любом изменении формата
+const uint32_t MAPPED_INDEX_FORMAT_VERSION = 1;
+// Секции файла выравниваются по этой границе
+const size_t MAPPED_INDEX_ALIGNMENT = 8;
+
+// Формат файла, который пишет SearchServer::SaveMappedIndex. Все данные лежат
+// плоскими выровненными массивами, на которые заголовок ссылается смещениями
+// от начала файла; порядок байтов - порядок процессора.
+struct MappedIndexSection {
+	uint64_t offset;
+	uint64_t size;
+};
+
+// Термин и его список вхождений: блоки blocks[first_block, first_block + block_count),
+// смещения данных блоков отсчитываются от posting_data + data_offset
+struct MappedIndexTerm {
+	uint64_t first_block;
+	uint64_t data_offset;
+	uint64_t data_size;
+	uint32_t block_count;
+	uint32_t document_count;
+	float max_term_freq;
+	uint32_t reserved;
+};
+
+struct MappedIndexHeader {
+	char magic[8];
+	uint32_t format_version;
+	uint32_t reserved;
+	uint64_t file_size;
+	uint64_t document_count;
+	uint64_t term_count;
+	uint64_t stop_word_count;
+	// смещения строк (count + 1 значений uint64_t) и их символы
+	MappedIndexSection stop_word_offsets;
+	MappedIndexSection stop_word_chars;
+	// слова индекса по возрастанию; номер слова - номер термина
+	MappedIndexSection term_offsets;
+	MappedIndexSection term_chars;
+	MappedIndexSection terms;
+	MappedIndexSection blocks;
+	MappedIndexSection posting_data;
+	// данные документов по внутреннему номеру
+	MappedIndexSection document_ids;
+	MappedIndexSection ratings;
+	MappedIndexSection statuses;
+	MappedIndexSection inv_word_counts;
+	// пары (id, номер) по возрастанию id
+	MappedIndexSection id_to_ordinal;
+};
+
+struct MappedIndexDocumentId {
+	int32_t document_id;
+	uint32_t ordinal;
+};
+
+const char MAPPED_INDEX_MAGIC[8] = {'S', 'R', 'V', 'M', 'A', 'P', 'I', 'X'};
+
+// Поисковый сервер только для чтения, который работает прямо с отображённым
+// в память файлом индекса: открытие не читает файл, страницы подгружаются
+// по мере обращения и делятся между процессами, а индекс больше памяти
+// вытесняется из кэша страниц, а не исчерпывает её. Выдача совпадает
+// с SearchServer, из которого записан файл.
+// При открытии проверяются заголовок и границы секций, а при чтении термина -
+// границы его списка; содержимое блоков не проверяется.
+class MappedSearchServer {
+public:
+	explicit MappedSearchServer(const std::string& path);
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+			DocumentStatus status = DocumentStatus::ACTUAL,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
+			int document_id) const;
+
+	int GetDocumentCount() const;
+	bool HasDocument(int document_id) const;
+
+private:
+	MappedFile file_;
+	const MappedIndexHeader* header_;
+	std::set<std::string, std::less<>> stop_words_;
+
+	const uint64_t* term_offsets_;
+	const char* term_chars_;
+	const MappedIndexTerm* terms_;
+	const PostingList::Block* blocks_;
+	const uint8_t* posting_data_;
+	const int32_t* document_ids_;
+	const int32_t* ratings_;
+	const uint8_t* statuses_;
+	const double* inv_word_counts_;
+	const MappedIndexDocumentId* id_to_ordinal_;
+
+	static constexpr uint32_t NO_TERM = std::numeric_limits<uint32_t>::max();
+
+	struct QueryTerm {
+		std::string_view word;
+		uint32_t term_index;
+	};
+	struct Query {
+		// слова без повторов, по возрастанию
+		SmallVector<QueryTerm, QUERY_INLINE_TERM_COUNT> plus_terms;
+		SmallVector<QueryTerm, QUERY_INLINE_TERM_COUNT> minus_terms;
+	};
+	Query ParseQuery(std::string_view text) const;
+
+	// Номер термина или NO_TERM
+	uint32_t FindTerm(std::string_view word) const;
+	std::string_view GetTerm(uint32_t term_index) const;
+	// Проверенный заголовок списка вхождений термина
+	const MappedIndexTerm& GetPostings(uint32_t term_index) const;
+	// Номер документа или PostingList::NO_ORDINAL, если документа нет
+	uint32_t FindOrdinal(int document_id) const;
+
+	// Вызывает func(begin, end) для вхождений каждого блока термина
+	template <typename Func>
+	void ForEachBlock(uint32_t term_index, Func func) const;
+	bool Contains(uint32_t term_index, uint32_t ordinal) const;
+	static void CheckBlock(const PostingList::Block& block, const MappedIndexTerm& term);
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate, size_t max_document_count) const {
+	const Query query = ParseQuery(raw_query);
+	const uint32_t document_count = static_cast<uint32_t>(header_->document_count);
+
+	// тот же порядок обхода, что и у SearchServer, поэтому совпадают и суммы, и порядок равных
+	auto& accumulator = ScoreAccumulator::ForCurrentThread();
+	accumulator.Reset(document_count);
+	const auto check_ordinal = [document_count](uint32_t ordinal) {
+		if (ordinal >= document_count) {
+			throw std::runtime_error("Mapped index is corrupted");
+		}
+	};
+	for (const QueryTerm& term : query.minus_terms) {
+		if (term.term_index == NO_TERM) {
+			continue;
+		}
+		ForEachBlock(term.term_index, [&](const Posting* begin, const Posting* end) {
+			for (const Posting* posting = begin; posting != end; ++posting) {
+				check_ordinal(posting->ordinal);
+				accumulator.Reject(posting->ordinal);
+			}
+		});
+	}
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_index == NO_TERM) {
+			continue;
+		}
+		const double inverse_document_freq =
+				std::log(document_count * 1.0 / GetPostings(term.term_index).document_count);
+		ForEachBlock(term.term_index, [&](const Posting* begin, const Posting* end) {
+			for (const Posting* posting = begin; posting != end; ++posting) {
+				const uint32_t ordinal = posting->ordinal;
+				check_ordinal(ordinal);
+				if (accumulator.IsRejected(ordinal)) {
+					continue;
+				}
+				if (!accumulator.IsAccepted(ordinal) && !document_predicate(document_ids_[ordinal],
+						static_cast<DocumentStatus>(statuses_[ordinal]), ratings_[ordinal])) {
+					accumulator.Reject(ordinal);
+					continue;
+				}
+				const double term_freq = posting->term_count * inv_word_counts_[ordinal];
+				accumulator.Add(ordinal, term_freq * inverse_document_freq);
+			}
+		});
+	}
+
+	TopDocumentsCollector collector(max_document_count);
+	accumulator.ForEach([&](uint32_t ordinal, double relevance) {
+		collector.Add({document_ids_[ordinal], relevance, ratings_[ordinal]});
+	});
+	return std::move(collector).Extract();
+}
+
+template <typename Func>
+void MappedSearchServer::ForEachBlock(uint32_t term_index, Func func) const {
+	const MappedIndexTerm& term = GetPostings(term_index);
+	const uint8_t* data = posting_data_ + term.data_offset;
+	std::array<Posting, PostingList::BLOCK_SIZE> postings;
+	for (uint64_t i = 0; i < term.block_count; ++i) {
+		const PostingList::Block& block = blocks_[term.first_block + i];
+		CheckBlock(block, term);
+		const size_t count = PostingList::DecodeBlock(block, data, postings.data());
+		func(postings.data(), postings.data() + count);
+	}
+}
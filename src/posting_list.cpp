@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "posting_list.h"
+
+using namespace std;
+
+namespace {
+
+void WriteVarByte(uint32_t value, vector<uint8_t>& out) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarByte(const uint8_t*& data) {
+	uint32_t value = 0;
+	for (int shift = 0;; shift += 7) {
+		const uint8_t byte = *data++;
+		value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+		if (byte < 0x80) {
+			return value;
+		}
+	}
+}
+
+// Граница хранится во float, поэтому округляем вверх, чтобы она оставалась границей
+float RoundUp(double value) {
+	const float rounded = static_cast<float>(value);
+	return rounded < value ? nextafter(rounded, numeric_limits<float>::infinity()) : rounded;
+}
+
+} // namespace
+
+void PostingList::Append(uint32_t ordinal, uint32_t term_count, double term_freq) {
+	if (blocks_.empty() || blocks_.back().count == BLOCK_SIZE) {
+		// первый документ блока хранится в заголовке, в данных только количество
+		blocks_.push_back({ordinal, ordinal, static_cast<uint32_t>(data_.size()), 0, 0.0f});
+	} else {
+		WriteVarByte(ordinal - blocks_.back().last_ordinal, data_);
+	}
+	WriteVarByte(term_count, data_);
+
+	Block& block = blocks_.back();
+	block.last_ordinal = ordinal;
+	++block.count;
+	block.max_term_freq = max(block.max_term_freq, RoundUp(term_freq));
+	max_term_freq_ = max(max_term_freq_, block.max_term_freq);
+	++size_;
+}
+
+void PostingList::RemapOrdinals(const vector<uint32_t>& new_ordinals) {
+	PostingList result;
+	array<Posting, BLOCK_SIZE> postings;
+	for (size_t block_index = 0; block_index < blocks_.size(); ++block_index) {
+		const size_t count = DecodeBlock(block_index, postings.data());
+		// старая граница частоты блока остаётся верхней границей для его вхождений
+		const float max_term_freq = blocks_[block_index].max_term_freq;
+		for (size_t i = 0; i < count; ++i) {
+			const uint32_t ordinal = new_ordinals[postings[i].ordinal];
+			if (ordinal != NO_ORDINAL) {
+				result.Append(ordinal, postings[i].term_count, max_term_freq);
+			}
+		}
+	}
+	result.blocks_.shrink_to_fit();
+	result.data_.shrink_to_fit();
+	*this = move(result);
+}
+
+bool PostingList::Contains(uint32_t ordinal) const {
+	const size_t block_index = LowerBoundBlock(ordinal);
+	if (block_index == blocks_.size() || blocks_[block_index].first_ordinal > ordinal) {
+		return false;
+	}
+
+	array<Posting, BLOCK_SIZE> postings;
+	const size_t count = DecodeBlock(block_index, postings.data());
+	return any_of(postings.begin(), postings.begin() + count, [ordinal](const Posting& posting) {
+		return posting.ordinal == ordinal;
+	});
+}
+
+size_t PostingList::size() const {
+	return size_;
+}
+
+bool PostingList::empty() const {
+	return size_ == 0;
+}
+
+size_t PostingList::GetMemoryUsage() const {
+	return sizeof(*this) + blocks_.capacity() * sizeof(Block) + data_.capacity();
+}
+
+void PostingList::SaveTo(BinaryWriter& writer) const {
+	writer.Write<uint64_t>(size_);
+	writer.Write(max_term_freq_);
+	writer.WriteVector(blocks_);
+	writer.WriteVector(data_);
+}
+
+PostingList PostingList::LoadFrom(BinaryReader& reader) {
+	PostingList result;
+	result.size_ = reader.Read<uint64_t>();
+	result.max_term_freq_ = reader.Read<float>();
+	result.blocks_ = reader.ReadVector<Block>();
+	result.data_ = reader.ReadVector<uint8_t>();
+	return result;
+}
+
+double PostingList::GetMaxTermFreq() const {
+	return max_term_freq_;
+}
+
+const vector<PostingList::Block>& PostingList::GetBlocks() const {
+	return blocks_;
+}
+
+const vector<uint8_t>& PostingList::GetData() const {
+	return data_;
+}
+
+size_t PostingList::DecodeBlock(size_t block_index, Posting* postings) const {
+	return DecodeBlock(blocks_[block_index], data_.data(), postings);
+}
+
+size_t PostingList::DecodeBlock(const Block& block, const uint8_t* data, Posting* postings) {
+	data += block.offset;
+
+	uint32_t ordinal = block.first_ordinal;
+	postings[0] = {ordinal, ReadVarByte(data)};
+	for (size_t i = 1; i < block.count; ++i) {
+		ordinal += ReadVarByte(data);
+		postings[i] = {ordinal, ReadVarByte(data)};
+	}
+	return block.count;
+}
+
+size_t PostingList::LowerBoundBlock(uint32_t ordinal) const {
+	const auto it = lower_bound(blocks_.begin(), blocks_.end(), ordinal, [](const Block& block, uint32_t ordinal) {
+		return block.last_ordinal < ordinal;
+	});
+	return it - blocks_.begin();
+}
+
+PostingList::Cursor::Cursor(const PostingList& postings)
+: postings_(&postings)
+{
+	LoadBlock(0);
+}
+
+void PostingList::Cursor::NextGEQ(uint32_t ordinal) {
+	if (IsEnd() || Get().ordinal >= ordinal) {
+		return;
+	}
+	const auto& blocks = postings_->blocks_;
+	if (blocks[block_index_].last_ordinal < ordinal) {
+		const auto it = lower_bound(blocks.begin() + block_index_ + 1, blocks.end(), ordinal,
+				[](const Block& block, uint32_t ordinal) {
+			return block.last_ordinal < ordinal;
+		});
+		LoadBlock(it - blocks.begin());
+		if (IsEnd()) {
+			return;
+		}
+	}
+	// в текущем блоке точно есть документ с номером не меньше ordinal
+	while (decoded_[position_].ordinal < ordinal) {
+		++position_;
+	}
+}
+
+void PostingList::Cursor::ShallowSeek(uint32_t ordinal) {
+	const auto& blocks = postings_->blocks_;
+	shallow_index_ = max(shallow_index_, block_index_);
+	while (shallow_index_ < blocks.size() && blocks[shallow_index_].last_ordinal < ordinal) {
+		++shallow_index_;
+	}
+}
+
+double PostingList::Cursor::GetBlockMaxTermFreq() const {
+	const auto& blocks = postings_->blocks_;
+	return shallow_index_ < blocks.size() ? blocks[shallow_index_].max_term_freq : 0.0;
+}
+
+uint32_t PostingList::Cursor::GetBlockLastOrdinal() const {
+	const auto& blocks = postings_->blocks_;
+	return shallow_index_ < blocks.size() ? blocks[shallow_index_].last_ordinal : numeric_limits<uint32_t>::max();
+}
+
+void PostingList::Cursor::LoadBlock(size_t block_index) {
+	block_index_ = block_index;
+	position_ = 0;
+	count_ = IsEnd() ? 0 : postings_->DecodeBlock(block_index_, decoded_.data());
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "binary_io.h"
+
+// Вхождение термина в документ. Вместо частоты хранится количество вхождений
+// термина в документ: частота получается делением на длину документа, поэтому
+// такое квантование не теряет точности.
+struct Posting {
+	uint32_t ordinal;
+	uint32_t term_count;
+};
+
+// Список вхождений термина, отсортированный по внутреннему номеру документа.
+// Вхождения хранятся блоками по BLOCK_SIZE штук: номер первого документа блока
+// лежит в заголовке, остальные закодированы разностями в формате variable-byte.
+// Дописывать можно только документы с номером больше последнего.
+// Для динамического отсечения в заголовке блока хранится верхняя граница
+// частоты термина в документах блока.
+class PostingList {
+public:
+	static constexpr size_t BLOCK_SIZE = 128;
+	static constexpr uint32_t NO_ORDINAL = std::numeric_limits<uint32_t>::max();
+
+	class Cursor;
+
+	// Заголовок блока; offset - смещение данных блока от начала данных списка
+	struct Block {
+		uint32_t first_ordinal;
+		uint32_t last_ordinal;
+		uint32_t offset;
+		uint32_t count;
+		float max_term_freq;
+	};
+
+	// Декодирует вхождения блока в postings, возвращает их число
+	static size_t DecodeBlock(const Block& block, const uint8_t* data, Posting* postings);
+
+	// term_freq - частота термина в документе, нужна только для верхних границ
+	void Append(uint32_t ordinal, uint32_t term_count, double term_freq);
+	// Переписывает список за один проход, заменяя номер каждого документа на
+	// new_ordinals[ordinal]; документы с номером NO_ORDINAL удаляются.
+	// Отображение должно сохранять порядок номеров.
+	void RemapOrdinals(const std::vector<uint32_t>& new_ordinals);
+
+	bool Contains(uint32_t ordinal) const;
+
+	size_t size() const;
+	bool empty() const;
+
+	size_t GetMemoryUsage() const;
+
+	// Сохраняет и восстанавливает список целиком, без перекодирования блоков
+	void SaveTo(BinaryWriter& writer) const;
+	static PostingList LoadFrom(BinaryReader& reader);
+
+	// Блоки и закодированные данные списка для форматов, хранящих их вне списка
+	const std::vector<Block>& GetBlocks() const;
+	const std::vector<uint8_t>& GetData() const;
+
+	// Верхняя граница частоты термина во всех документах списка
+	double GetMaxTermFreq() const;
+
+	// Обходит вхождения по возрастанию номера документа, декодируя по блоку за раз
+	template <typename Func>
+	void ForEach(Func func) const;
+	// То же для документов с номерами из [first_ordinal, last_ordinal); блоки вне диапазона не декодируются
+	template <typename Func>
+	void ForEachInRange(uint32_t first_ordinal, uint32_t last_ordinal, Func func) const;
+
+	// Передаёт func(begin, end) вхождения каждого блока, попавшие в [first_ordinal, last_ordinal).
+	// Если func вернула false, обход прекращается и метод возвращает false.
+	template <typename Func>
+	bool ForEachBlockInRange(uint32_t first_ordinal, uint32_t last_ordinal, Func func) const;
+
+	// Вызывает func(first_ordinal, count) для каждого блока, читая только заголовки
+	template <typename Func>
+	void ForEachBlock(Func func) const;
+
+private:
+	std::vector<Block> blocks_;
+	std::vector<uint8_t> data_;
+	size_t size_ = 0;
+	float max_term_freq_ = 0.0f;
+
+	size_t DecodeBlock(size_t block_index, Posting* postings) const;
+	// Первый блок, в котором могут быть документы с номером не меньше ordinal
+	size_t LowerBoundBlock(uint32_t ordinal) const;
+};
+
+// Курсор для обхода документ-за-документом с пропуском блоков.
+// Кроме текущего вхождения курсор хранит "неглубокую" позицию - блок, заголовок
+// которого уже прочитан, но содержимое ещё не декодировано.
+class PostingList::Cursor {
+public:
+	explicit Cursor(const PostingList& postings);
+
+	bool IsEnd() const {
+		return block_index_ == postings_->blocks_.size();
+	}
+
+	const Posting& Get() const {
+		return decoded_[position_];
+	}
+
+	void Next() {
+		if (++position_ == count_) {
+			LoadBlock(block_index_ + 1);
+		}
+	}
+
+	// Переходит к первому вхождению с номером документа не меньше ordinal
+	void NextGEQ(uint32_t ordinal);
+
+	// Переводит неглубокую позицию на блок, который может содержать ordinal
+	void ShallowSeek(uint32_t ordinal);
+	// Верхняя граница частоты термина и последний документ блока неглубокой позиции
+	double GetBlockMaxTermFreq() const;
+	uint32_t GetBlockLastOrdinal() const;
+
+private:
+	const PostingList* postings_;
+	size_t block_index_ = 0;
+	size_t shallow_index_ = 0;
+	size_t position_ = 0;
+	size_t count_ = 0;
+	std::array<Posting, BLOCK_SIZE> decoded_;
+
+	void LoadBlock(size_t block_index);
+};
+
+template <typename Func>
+void PostingList::ForEach(Func func) const {
+	std::array<Posting, BLOCK_SIZE> postings;
+	for (size_t block_index = 0; block_index < blocks_.size(); ++block_index) {
+		const size_t count = DecodeBlock(block_index, postings.data());
+		for (size_t i = 0; i < count; ++i) {
+			func(postings[i]);
+		}
+	}
+}
+
+template <typename Func>
+void PostingList::ForEachInRange(uint32_t first_ordinal, uint32_t last_ordinal, Func func) const {
+	ForEachBlockInRange(first_ordinal, last_ordinal, [&func](const Posting* begin, const Posting* end) {
+		std::for_each(begin, end, func);
+		return true;
+	});
+}
+
+template <typename Func>
+bool PostingList::ForEachBlockInRange(uint32_t first_ordinal, uint32_t last_ordinal, Func func) const {
+	std::array<Posting, BLOCK_SIZE> postings;
+	const auto is_before = [](const Posting& posting, uint32_t ordinal) {
+		return posting.ordinal < ordinal;
+	};
+	for (size_t block_index = LowerBoundBlock(first_ordinal);
+			block_index < blocks_.size() && blocks_[block_index].first_ordinal < last_ordinal; ++block_index) {
+		const size_t count = DecodeBlock(block_index, postings.data());
+		const Posting* begin = postings.data();
+		const Posting* end = postings.data() + count;
+		// отрезок обрезается только в крайних блоках диапазона
+		if (begin->ordinal < first_ordinal) {
+			begin = std::lower_bound(begin, end, first_ordinal, is_before);
+		}
+		if ((end - 1)->ordinal >= last_ordinal) {
+			end = std::lower_bound(begin, end, last_ordinal, is_before);
+		}
+		if (!func(begin, end)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename Func>
+void PostingList::ForEachBlock(Func func) const {
+	for (const Block& block : blocks_) {
+		func(block.first_ordinal, block.count);
+	}
+}
@@ -1,29 +1,29 @@
-#include <algorithm>
-#include <functional>
-#include <execution>
+#include <string_view>
 #include <vector>
-#include <utility>
 
 #include "process_queries.h"
 
 using namespace std;
 
-vector<vector<Document>> ProcessQueries(
-	const SearchServer& search_server,
+namespace {
+
+template <typename SearchServerType>
+vector<vector<Document>> ProcessQueriesInParallel(
+	const SearchServerType& search_server,
 	const vector<string>& queries) {
 	vector<vector<Document>> result(queries.size());
 
-	transform(execution::par,
-			queries.cbegin(), queries.cend(),
-			result.begin(),
-			[&search_server](const auto& query) { return search_server.FindTopDocuments(query); }
-			);
+	// запросы раздаются потокам по одному, поэтому дорогие запросы не задерживают дешёвые
+	ThreadPool::GetDefault().ParallelFor(queries.size(), [&](size_t index) {
+		result[index] = search_server.FindTopDocuments(queries[index]);
+	});
 
 	return result;
 }
 
-vector<Document> ProcessQueriesJoined(
-	const SearchServer& search_server,
+template <typename SearchServerType>
+vector<Document> JoinQueryResults(
+	const SearchServerType& search_server,
 	const vector<string>& queries) {
 	vector<Document> result;
 	for (const auto& local_documents : ProcessQueries(search_server, queries)) {
@@ -31,3 +31,35 @@ vector<Document> ProcessQueriesJoined(
 	}
 	return result;
 }
+
+} // namespace
+
+vector<vector<Document>> ProcessQueries(
+	const SearchServer& search_server,
+	const vector<string>& queries) {
+	return search_server.FindTopDocumentsBatch(vector<string_view>(queries.begin(), queries.end()));
+}
+
+vector<vector<Document>> ProcessQueries(
+	const ShardedSearchServer& search_server,
+	const vector<string>& queries) {
+	return ProcessQueriesInParallel(search_server, queries);
+}
+
+vector<vector<Document>> ProcessQueries(
+	const ConcurrentSearchServer& search_server,
+	const vector<string>& queries) {
+	return ProcessQueries(*search_server.GetSnapshot(), queries);
+}
+
+vector<Document> ProcessQueriesJoined(
+	const SearchServer& search_server,
+	const vector<string>& queries) {
+	return JoinQueryResults(search_server, queries);
+}
+
+vector<Document> ProcessQueriesJoined(
+	const ShardedSearchServer& search_server,
+	const vector<string>& queries) {
+	return JoinQueryResults(search_server, queries);
+}
@@ -3,14 +3,29 @@
 #include <string>
 #include <vector>
 
+#include "concurrent_search_server.h"
 #include "document.h"
 #include "search_server.h"
+#include "sharded_search_server.h"
 
 
 std::vector<std::vector<Document>> ProcessQueries(
 	const SearchServer& search_server,
 	const std::vector<std::string>& queries);
 
+// Все запросы выполняются по одному снимку индекса
+std::vector<std::vector<Document>> ProcessQueries(
+	const ConcurrentSearchServer& search_server,
+	const std::vector<std::string>& queries);
+
+std::vector<std::vector<Document>> ProcessQueries(
+	const ShardedSearchServer& search_server,
+	const std::vector<std::string>& queries);
+
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
+
+std::vector<Document> ProcessQueriesJoined(
+	const ShardedSearchServer& search_server,
+	const std::vector<std::string>& queries);
@@ -12,7 +12,7 @@ using namespace std;
 
 void RemoveDuplicates(SearchServer& search_server) {
 	map<set<string_view>, int> unique_words_to_document_id;
-	list<int> garbage;
+	vector<int> garbage;
 
 	for (const auto document_id : search_server) {
 		const auto& word_freqs = search_server.GetWordFrequencies(document_id);
@@ -36,6 +36,6 @@ void RemoveDuplicates(SearchServer& search_server) {
 
 	for (const auto& document_id : garbage) {
 		cout << "Found duplicate document id " << document_id << endl;
-		search_server.RemoveDocument(document_id);
 	}
+	search_server.RemoveDocuments(garbage);
 }
@@ -6,29 +6,29 @@
 using namespace std;
 
 RequestQueue::RequestQueue(const SearchServer& search_server) :
-	search_server_(search_server)
+	search_server_(&search_server)
+{
+}
+
+RequestQueue::RequestQueue(const ShardedSearchServer& search_server) :
+	sharded_search_server_(&search_server)
 {
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-	++seconds;
-	const auto& result = search_server_.FindTopDocuments(raw_query, status);
-	if (result.empty()) {
-		++no_result_requests_;
-	}
-	requests_.push_back(QueryResult{raw_query, result.size()});
-	if (requests_.size() > sec_in_day_) {
-	if (requests_.front().found_docs_amount == 0){
-			--no_result_requests_;
-		}
-		requests_.pop_front();
-	}
-	return result;
+	return AddResult(raw_query, FindTopDocuments(raw_query, status));
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
+	return AddResult(raw_query, FindTopDocuments(raw_query));
+}
+
+int RequestQueue::GetNoResultRequests() const {
+	return no_result_requests_;
+}
+
+vector<Document> RequestQueue::AddResult(const string& raw_query, vector<Document> result) {
 	++seconds;
-	const auto& result = search_server_.FindTopDocuments(raw_query);
 	if (result.empty()) {
 		++no_result_requests_;
 	}
@@ -41,7 +41,3 @@ vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
 	}
 	return result;
 }
-
-int RequestQueue::GetNoResultRequests() const {
-	return no_result_requests_;
-}
@@ -5,10 +5,12 @@
 #include <vector>
 
 #include "search_server.h"
+#include "sharded_search_server.h"
 
 class RequestQueue {
 public:
 	RequestQueue(const SearchServer& search_server);
+	RequestQueue(const ShardedSearchServer& search_server);
 
 	template <typename DocumentPredicate>
 	std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
@@ -26,23 +28,24 @@ private:
 	const static int sec_in_day_ = 1440; // это кол-во минут в дне
 	int seconds = 0;
 	int no_result_requests_ = 0;
-	const SearchServer& search_server_;
+	// задан ровно один из серверов
+	const SearchServer* search_server_ = nullptr;
+	const ShardedSearchServer* sharded_search_server_ = nullptr;
+
+	template <typename... Args>
+	std::vector<Document> FindTopDocuments(const Args&... args) const;
+	std::vector<Document> AddResult(const std::string& raw_query, std::vector<Document> result);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-	++seconds;
-	const auto& result = RequestQueue::search_server_.FindTopDocuments(raw_query, document_predicate);
-	if (result.empty()) {
-		++no_result_requests_;
-	}
-	requests_.push_back(QueryResult{raw_query, result.size()});
-	if (requests_.size() > sec_in_day_) {
-		if (requests_.front().found_docs_amount == 0){
-			--no_result_requests_;
-		}
-		requests_.pop_front();
-	}
-	return result;
+	return AddResult(raw_query, FindTopDocuments(raw_query, document_predicate));
+}
 
+template <typename... Args>
+std::vector<Document> RequestQueue::FindTopDocuments(const Args&... args) const {
+	if (sharded_search_server_) {
+		return sharded_search_server_->FindTopDocuments(args...);
+	}
+	return search_server_->FindTopDocuments(args...);
 }
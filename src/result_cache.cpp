@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "result_cache.h"
+
+using namespace std;
+
+ResultCache::ResultCache(size_t capacity)
+: capacity_(capacity)
+{
+	// остаток от деления ёмкости достаётся первым частям по одной записи
+	const size_t shard_count = min(capacity_, RESULT_CACHE_SHARD_COUNT);
+	for (size_t i = 0; i < shard_count; ++i) {
+		shards_.push_back(make_unique<Shard>());
+		shards_.back()->capacity = capacity_ / shard_count + (i < capacity_ % shard_count ? 1 : 0);
+	}
+}
+
+ResultCache::ResultCache(const ResultCache& other)
+: ResultCache(other.capacity_)
+{
+}
+
+ResultCache& ResultCache::operator=(const ResultCache& other) {
+	if (this != &other) {
+		ResultCache cache(other.capacity_);
+		capacity_ = cache.capacity_;
+		shards_ = move(cache.shards_);
+		hits_ = 0;
+		misses_ = 0;
+	}
+	return *this;
+}
+
+bool ResultCache::IsEnabled() const {
+	return capacity_ > 0;
+}
+
+optional<vector<Document>> ResultCache::Find(const string& key, uint64_t version) const {
+	Shard& shard = GetShard(key);
+	lock_guard guard(shard.mutex);
+	const auto it = shard.index.find(key);
+	if (it == shard.index.end() || it->second->version != version) {
+		++misses_;
+		return nullopt;
+	}
+	shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+	++hits_;
+	return it->second->documents;
+}
+
+void ResultCache::Insert(string key, uint64_t version, vector<Document> documents) const {
+	Shard& shard = GetShard(key);
+	lock_guard guard(shard.mutex);
+	const auto it = shard.index.find(key);
+	if (it != shard.index.end()) {
+		// запись устаревшей версии обновляется на месте
+		it->second->version = version;
+		it->second->documents = move(documents);
+		shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+		return;
+	}
+
+	shard.entries.push_front({move(key), version, move(documents)});
+	shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+	if (shard.entries.size() > shard.capacity) {
+		shard.index.erase(shard.entries.back().key);
+		shard.entries.pop_back();
+	}
+}
+
+ResultCacheStats ResultCache::GetStats() const {
+	return {hits_.load(), misses_.load()};
+}
+
+size_t ResultCache::GetSize() const {
+	size_t size = 0;
+	for (const auto& shard : shards_) {
+		lock_guard guard(shard->mutex);
+		size += shard->entries.size();
+	}
+	return size;
+}
+
+ResultCache::Shard& ResultCache::GetShard(string_view key) const {
+	return *shards_[hash<string_view>{}(key) % shards_.size()];
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+// На столько независимых частей со своим мьютексом делится кэш результатов
+const size_t RESULT_CACHE_SHARD_COUNT = 16;
+
+struct ResultCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
+// Кэш результатов поиска с вытеснением давно не использованных записей (LRU).
+// Ключи распределяются по частям хешем, так что параллельные запросы редко ждут
+// друг друга. Частей не больше ёмкости, и их ёмкости в сумме дают ёмкость кэша.
+// Каждая запись помечена версией индекса: запись другой версии
+// считается промахом и заменяется новым результатом.
+// Копия кэша пуста, но имеет ту же ёмкость: у копии сервера свои версии индекса.
+class ResultCache {
+public:
+	// Нулевая ёмкость выключает кэш
+	explicit ResultCache(size_t capacity = 0);
+	ResultCache(const ResultCache& other);
+	ResultCache& operator=(const ResultCache& other);
+
+	bool IsEnabled() const;
+
+	std::optional<std::vector<Document>> Find(const std::string& key, uint64_t version) const;
+	void Insert(std::string key, uint64_t version, std::vector<Document> documents) const;
+
+	ResultCacheStats GetStats() const;
+	// Число записей во всех частях
+	size_t GetSize() const;
+
+private:
+	struct Entry {
+		std::string key;
+		uint64_t version;
+		std::vector<Document> documents;
+	};
+
+	struct Shard {
+		std::mutex mutex;
+		size_t capacity = 0;
+		// в начале списка - недавно использованные записи
+		std::list<Entry> entries;
+		std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+	};
+
+	size_t capacity_;
+	std::vector<std::unique_ptr<Shard>> shards_;
+	mutable std::atomic<uint64_t> hits_ = 0;
+	mutable std::atomic<uint64_t> misses_ = 0;
+
+	Shard& GetShard(std::string_view key) const;
+};
@@ -0,0 +1,24 @@
+#include <cstdint>
+#include <vector>
+
+#include "score_accumulator.h"
+
+using namespace std;
+
+ScoreAccumulator& ScoreAccumulator::ForCurrentThread() {
+	static thread_local ScoreAccumulator accumulator;
+	return accumulator;
+}
+
+void ScoreAccumulator::Reset(size_t ordinal_count) {
+	for (const uint32_t ordinal : touched_) {
+		scores_[ordinal] = 0.0;
+		states_[ordinal] = UNTOUCHED;
+	}
+	touched_.clear();
+
+	if (scores_.size() < ordinal_count) {
+		scores_.resize(ordinal_count, 0.0);
+		states_.resize(ordinal_count, UNTOUCHED);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Накопитель релевантности документов, адресуемых внутренними номерами.
+// Хранит плотные массивы оценок и состояний и список затронутых номеров,
+// поэтому сброс между запросами стоит O(число затронутых документов).
+class ScoreAccumulator {
+public:
+	// Накопитель текущего потока; переиспользуется между запросами
+	static ScoreAccumulator& ForCurrentThread();
+
+	// Очищает результаты предыдущего запроса и готовит место под ordinal_count документов
+	void Reset(size_t ordinal_count);
+
+	void Add(uint32_t ordinal, double score) {
+		if (states_[ordinal] == UNTOUCHED) {
+			states_[ordinal] = ACCEPTED;
+			touched_.push_back(ordinal);
+		}
+		scores_[ordinal] += score;
+	}
+
+	// Исключает документ из результатов, например из-за минус-слова
+	void Reject(uint32_t ordinal) {
+		if (states_[ordinal] == UNTOUCHED) {
+			touched_.push_back(ordinal);
+		}
+		states_[ordinal] = REJECTED;
+	}
+
+	bool IsAccepted(uint32_t ordinal) const {
+		return states_[ordinal] == ACCEPTED;
+	}
+
+	bool IsRejected(uint32_t ordinal) const {
+		return states_[ordinal] == REJECTED;
+	}
+
+	// Обходит принятые документы в порядке первого обращения к ним
+	template <typename Func>
+	void ForEach(Func func) const;
+
+private:
+	enum State : uint8_t {
+		UNTOUCHED,
+		ACCEPTED,
+		REJECTED,
+	};
+
+	std::vector<double> scores_;
+	std::vector<State> states_;
+	std::vector<uint32_t> touched_;
+};
+
+template <typename Func>
+void ScoreAccumulator::ForEach(Func func) const {
+	for (const uint32_t ordinal : touched_) {
+		if (states_[ordinal] == ACCEPTED) {
+			func(ordinal, scores_[ordinal]);
+		}
+	}
+}
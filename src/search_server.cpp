@@ -1,17 +1,28 @@
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 #include <execution>
 #include <algorithm>
+#include <future>
 #include <exception>
 #include <execution>
-#include <list>
 #include <map>
 #include <set>
 #include <string>
 #include <string_view>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 
+#include "file_io.h"
+#include "mapped_search_server.h"
 #include "search_server.h"
+#include "tokenizer.h"
 
 using namespace std;
 
@@ -26,61 +37,446 @@ SearchServer::SearchServer(const string& stop_words_text)
 }
 
 void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
-	if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+	if ((document_id < 0) || (document_ordinals_.count(document_id) > 0)) {
 		throw invalid_argument("Invalid document_id"s);
 	}
-	document_ids_.push_back(document_id);
-
-	const auto& [document_id_to_data, _] = documents_.emplace(document_id,
-			SearchServer::DocumentData{string(document), ComputeAverageRating(ratings), status});
-	const auto words = SplitIntoWordsNoStop(document_id_to_data->second.document_data);
 
+	const auto words = SplitIntoWordsNoStop(document);
 	const double inv_word_count = 1.0 / words.size();
+	const uint32_t ordinal = AppendDocument(document_id, ComputeAverageRating(ratings), status, inv_word_count);
+	version_ = NextVersion();
+
+	map<TermId, uint32_t> term_counts;
 	for (const string_view word : words) {
-		word_to_document_freqs_[string(word)][document_id] += inv_word_count;
-		document_to_word_freqs_[document_id][word] += inv_word_count;
+		++term_counts[terms_.Intern(word)];
 	}
+	term_postings_.resize(terms_.size());
+	term_document_counts_.resize(terms_.size());
 
+	auto& term_freqs = document_to_term_freqs_[document_id];
+	for (const auto [term_id, term_count] : term_counts) {
+		const double term_freq = term_count * inv_word_count;
+		term_postings_[term_id].Append(ordinal, term_count, term_freq);
+		++term_document_counts_[term_id];
+		term_freqs.emplace(term_id, term_freq);
+	}
 }
-vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
-	return FindTopDocuments(execution::seq, raw_query, status);
+
+void SearchServer::AddDocuments(vector<NewDocument>&& documents) {
+	AddDocuments(PrepareDocuments(move(documents)));
+}
+
+PreparedDocuments SearchServer::PrepareDocuments(vector<NewDocument>&& documents) const {
+	PreparedDocuments prepared;
+	prepared.documents_ = move(documents);
+	prepared.chunks_.resize((prepared.documents_.size() + ADD_DOCUMENTS_CHUNK_SIZE - 1) / ADD_DOCUMENTS_CHUNK_SIZE);
+	ThreadPool::GetDefault().ParallelFor(prepared.chunks_.size(), [this, &prepared](size_t chunk_index) {
+		using BatchPosting = PreparedDocuments::BatchPosting;
+		const uint32_t NO_POSTING = numeric_limits<uint32_t>::max();
+		auto& chunk = prepared.chunks_[chunk_index];
+		const size_t first = chunk_index * ADD_DOCUMENTS_CHUNK_SIZE;
+		const size_t last = min(first + ADD_DOCUMENTS_CHUNK_SIZE, prepared.documents_.size());
+
+		// вхождения в порядке документов; повтор слова в документе увеличивает
+		// последнее вхождение этого слова
+		unordered_map<string_view, uint32_t> word_numbers;
+		vector<uint32_t> last_postings;
+		vector<BatchPosting> document_postings;
+		for (size_t index = first; index < last; ++index) {
+			const auto words = SplitIntoWordsNoStop(prepared.documents_[index].text);
+			chunk.inv_word_counts.push_back(1.0 / words.size());
+			for (const string_view word : words) {
+				const auto [it, is_new] = word_numbers.emplace(word, static_cast<uint32_t>(chunk.words.size()));
+				if (is_new) {
+					chunk.words.push_back(word);
+					last_postings.push_back(NO_POSTING);
+				}
+				uint32_t& last_posting = last_postings[it->second];
+				if (last_posting != NO_POSTING && document_postings[last_posting].ordinal == index) {
+					++document_postings[last_posting].term_count;
+				} else {
+					last_posting = static_cast<uint32_t>(document_postings.size());
+					document_postings.push_back({it->second, static_cast<uint32_t>(index), 1});
+				}
+			}
+		}
+
+		// группировка подсчётом сохраняет порядок документов внутри слова
+		chunk.word_offsets.assign(chunk.words.size() + 1, 0);
+		for (const BatchPosting& posting : document_postings) {
+			++chunk.word_offsets[posting.word + 1];
+		}
+		partial_sum(chunk.word_offsets.begin(), chunk.word_offsets.end(), chunk.word_offsets.begin());
+		vector<uint32_t> positions(chunk.word_offsets.begin(), chunk.word_offsets.end() - 1);
+		chunk.postings.resize(document_postings.size());
+		for (const BatchPosting& posting : document_postings) {
+			chunk.postings[positions[posting.word]++] = posting;
+		}
+	});
+	return prepared;
+}
+
+void SearchServer::AddDocuments(PreparedDocuments&& prepared) {
+	const vector<NewDocument>& documents = prepared.documents_;
+	unordered_set<int> batch_ids;
+	for (const auto& document : documents) {
+		if (document.id < 0 || document_ordinals_.count(document.id) > 0 || !batch_ids.insert(document.id).second) {
+			throw invalid_argument("Invalid document_id"s);
+		}
+	}
+
+	const uint32_t first_ordinal = static_cast<uint32_t>(ordinal_to_document_id_.size());
+	version_ = NextVersion();
+	// частоты пишутся сразу в прямой индекс
+	vector<map<TermId, double>*> term_freqs(documents.size());
+	for (size_t index = 0; index < documents.size(); ++index) {
+		term_freqs[index] = &document_to_term_freqs_[documents[index].id];
+	}
+	vector<TermId> term_ids;
+	vector<uint32_t> word_order;
+	for (size_t chunk_index = 0; chunk_index < prepared.chunks_.size(); ++chunk_index) {
+		const auto& chunk = prepared.chunks_[chunk_index];
+		const size_t first = chunk_index * ADD_DOCUMENTS_CHUNK_SIZE;
+		for (size_t i = 0; i < chunk.inv_word_counts.size(); ++i) {
+			const auto& document = documents[first + i];
+			AppendDocument(document.id, ComputeAverageRating(document.ratings), document.status, chunk.inv_word_counts[i]);
+		}
+
+		term_ids.resize(chunk.words.size());
+		for (size_t word = 0; word < chunk.words.size(); ++word) {
+			term_ids[word] = terms_.Intern(chunk.words[word]);
+		}
+		term_postings_.resize(terms_.size());
+		term_document_counts_.resize(terms_.size());
+		// по возрастанию терминов частоты документа добавляются в конец его словаря
+		word_order.resize(chunk.words.size());
+		iota(word_order.begin(), word_order.end(), 0);
+		sort(word_order.begin(), word_order.end(), [&term_ids](uint32_t lhs, uint32_t rhs) {
+			return term_ids[lhs] < term_ids[rhs];
+		});
+
+		// куски идут по возрастанию номеров, поэтому вхождения дописываются в конец списков
+		for (const uint32_t word : word_order) {
+			const TermId term_id = term_ids[word];
+			for (uint32_t i = chunk.word_offsets[word]; i < chunk.word_offsets[word + 1]; ++i) {
+				const auto& posting = chunk.postings[i];
+				const double term_freq = posting.term_count * chunk.inv_word_counts[posting.ordinal - first];
+				term_postings_[term_id].Append(first_ordinal + posting.ordinal, posting.term_count, term_freq);
+				auto& document_term_freqs = *term_freqs[posting.ordinal];
+				document_term_freqs.emplace_hint(document_term_freqs.end(), term_id, term_freq);
+			}
+			term_document_counts_[term_id] += chunk.word_offsets[word + 1] - chunk.word_offsets[word];
+		}
+	}
+}
+
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status,
+		size_t max_document_count) const {
+	return FindTopDocuments(execution::seq, raw_query, status, max_document_count);
 }
 vector<Document> SearchServer::FindTopDocuments(string_view raw_query) const {
 	return FindTopDocuments(execution::seq, raw_query);
 }
 
-vector<Document> SearchServer::FindTopDocuments(const execution::sequenced_policy&, string_view raw_query, DocumentStatus status) const {
-	return FindTopDocuments(execution::seq, raw_query, [status]([[maybe_unused]] int document_id,
-			DocumentStatus document_status, [[maybe_unused]] int rating) {
-		return document_status == status;
-	});
+vector<Document> SearchServer::FindTopDocuments(const execution::sequenced_policy&, string_view raw_query,
+		DocumentStatus status, size_t max_document_count) const {
+	return FindTopDocumentsByStatus(execution::seq, ParseQuery(raw_query), status, max_document_count);
 }
 vector<Document> SearchServer::FindTopDocuments(const execution::sequenced_policy&, string_view raw_query) const {
 	return FindTopDocuments(execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
-vector<Document> SearchServer::FindTopDocuments(const execution::parallel_policy&, string_view raw_query, DocumentStatus status) const {
-	return FindTopDocuments(execution::par, raw_query, [status]([[maybe_unused]] int document_id,
-			DocumentStatus document_status, [[maybe_unused]] int rating) {
-		return document_status == status;
-	});
+vector<Document> SearchServer::FindTopDocuments(const execution::parallel_policy&, string_view raw_query,
+		DocumentStatus status, size_t max_document_count) const {
+	return FindTopDocumentsByStatus(execution::par, ParseQuery(raw_query), status, max_document_count);
 }
 vector<Document> SearchServer::FindTopDocuments(const execution::parallel_policy&, string_view raw_query) const {
 	return FindTopDocuments(execution::par, raw_query, DocumentStatus::ACTUAL);
 }
 
+vector<Document> SearchServer::FindTopDocuments(const BlockMaxWandPolicy&, string_view raw_query,
+		DocumentStatus status, size_t max_document_count) const {
+	return FindTopDocumentsByStatus(block_max_wand, ParseQuery(raw_query), status, max_document_count);
+}
+vector<Document> SearchServer::FindTopDocuments(const BlockMaxWandPolicy&, string_view raw_query) const {
+	return FindTopDocuments(block_max_wand, raw_query, DocumentStatus::ACTUAL);
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsBatch(const vector<string_view>& raw_queries,
+		DocumentStatus status, size_t max_document_count) const {
+	vector<Query> queries;
+	queries.reserve(raw_queries.size());
+	for (const string_view raw_query : raw_queries) {
+		queries.push_back(ParseQuery(raw_query));
+	}
+	return FindTopDocumentsBatch(move(queries), status, max_document_count);
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsBatch(const vector<PreparedQuery>& prepared_queries,
+		DocumentStatus status, size_t max_document_count) const {
+	vector<Query> queries;
+	queries.reserve(prepared_queries.size());
+	for (const PreparedQuery& prepared_query : prepared_queries) {
+		queries.push_back(ResolveQuery(prepared_query));
+	}
+	return FindTopDocumentsBatch(move(queries), status, max_document_count);
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsBatch(vector<Query>&& queries,
+		DocumentStatus status, size_t max_document_count) const {
+	// одинаковые запросы выполняются один раз; ключ тот же, что у кэша результатов
+	map<string, uint32_t> query_to_unique_index;
+	vector<Query> unique_queries;
+	vector<uint32_t> unique_indexes;
+	unique_indexes.reserve(queries.size());
+	for (Query& query : queries) {
+		const auto [it, inserted] = query_to_unique_index.emplace(
+				MakeResultCacheKey(query, status, max_document_count), static_cast<uint32_t>(unique_queries.size()));
+		if (inserted) {
+			unique_queries.push_back(move(query));
+		}
+		unique_indexes.push_back(it->second);
+	}
+
+	// упорядоченные по словам запросы соседствуют с похожими, и пакеты чаще делят слова;
+	// запросы, результаты которых есть в кэше, не выполняются
+	vector<vector<Document>> unique_results(unique_queries.size());
+	vector<const string*> cache_keys(unique_queries.size());
+	vector<uint32_t> order;
+	order.reserve(unique_queries.size());
+	for (const auto& [key, unique_index] : query_to_unique_index) {
+		cache_keys[unique_index] = &key;
+		if (result_cache_.IsEnabled()) {
+			if (auto documents = result_cache_.Find(key, version_)) {
+				unique_results[unique_index] = move(*documents);
+				continue;
+			}
+		}
+		order.push_back(unique_index);
+	}
+
+	const size_t batch_count = (order.size() + QUERY_BATCH_SIZE - 1) / QUERY_BATCH_SIZE;
+	ThreadPool::GetDefault().ParallelFor(batch_count, [&](size_t batch) {
+		const size_t first = batch * QUERY_BATCH_SIZE;
+		const size_t last = min(first + QUERY_BATCH_SIZE, order.size());
+		// оценки вхождений слова считаются один раз на пакет: список декодируется,
+		// удалённые документы и документы с другим статусом отбрасываются, IDF учтён
+		unordered_map<TermId, vector<pair<uint32_t, double>>> scored_postings;
+		const auto get_scored_postings = [&](const QueryTerm& term) -> const vector<pair<uint32_t, double>>& {
+			auto [it, inserted] = scored_postings.try_emplace(term.term_id);
+			if (!inserted) {
+				return it->second;
+			}
+			const double inverse_document_freq = term.inverse_document_freq;
+			it->second.reserve(term_postings_[term.term_id].size());
+			term_postings_[term.term_id].ForEach([&](const Posting& posting) {
+				const int document_id = ordinal_to_document_id_[posting.ordinal];
+				if (document_id == REMOVED_DOCUMENT_ID) {
+					return;
+				}
+				if (GetDocumentStatus(posting.ordinal) == status) {
+					const double term_freq = posting.term_count * document_inv_word_counts_[posting.ordinal];
+					it->second.emplace_back(posting.ordinal, term_freq * inverse_document_freq);
+				}
+			});
+			return it->second;
+		};
+
+		auto& accumulator = ScoreAccumulator::ForCurrentThread();
+		for (size_t i = first; i < last; ++i) {
+			const Query& query = unique_queries[order[i]];
+			accumulator.Reset(ordinal_to_document_id_.size());
+			for (const QueryTerm& term : query.minus_terms) {
+				if (term.term_id != TermDictionary::NO_TERM) {
+					term_postings_[term.term_id].ForEach([&accumulator](const Posting& posting) {
+						accumulator.Reject(posting.ordinal);
+					});
+				}
+			}
+			// слова обходятся в том же порядке, что и в FindTopDocuments, поэтому
+			// суммы релевантности и порядок равных документов совпадают
+			for (const QueryTerm& term : query.plus_terms) {
+				if (term.term_id == TermDictionary::NO_TERM) {
+					continue;
+				}
+				for (const auto& [ordinal, score] : get_scored_postings(term)) {
+					if (!accumulator.IsRejected(ordinal)) {
+						accumulator.Add(ordinal, score);
+					}
+				}
+			}
+
+			TopDocumentsCollector collector(max_document_count);
+			accumulator.ForEach([&](uint32_t ordinal, double relevance) {
+				collector.Add({ordinal_to_document_id_[ordinal], relevance, document_ratings_[ordinal]});
+			});
+			unique_results[order[i]] = move(collector).Extract();
+			if (result_cache_.IsEnabled()) {
+				result_cache_.Insert(*cache_keys[order[i]], version_, unique_results[order[i]]);
+			}
+		}
+	});
+
+	vector<vector<Document>> results;
+	results.reserve(queries.size());
+	for (const uint32_t unique_index : unique_indexes) {
+		results.push_back(unique_results[unique_index]);
+	}
+	return results;
+}
+
+SearchResult SearchServer::FindTopDocuments(string_view raw_query, const SearchOptions& options) const {
+	return FindTopDocumentsWithOptions(ParseQuery(raw_query), options);
+}
+
+future<SearchResult> SearchServer::FindTopDocumentsAsync(string raw_query, SearchOptions options) const {
+	return ThreadPool::GetDefault().Submit([this, raw_query = move(raw_query), options] {
+		return FindTopDocuments(raw_query, options);
+	});
+}
+
+PreparedQuery SearchServer::PrepareQuery(string_view raw_query) const {
+	const Query query = ParseQuery(raw_query);
+	PreparedQuery result;
+	result.plus_terms_.reserve(query.plus_terms.size());
+	for (const QueryTerm& term : query.plus_terms) {
+		result.plus_terms_.push_back({string(term.word), term.term_id, term.inverse_document_freq});
+	}
+	result.minus_terms_.reserve(query.minus_terms.size());
+	for (const QueryTerm& term : query.minus_terms) {
+		result.minus_terms_.push_back({string(term.word), term.term_id, term.inverse_document_freq});
+	}
+	result.index_version_ = version_;
+	return result;
+}
+
+vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentStatus status,
+		size_t max_document_count) const {
+	return FindTopDocuments(execution::seq, query, status, max_document_count);
+}
+
+SearchResult SearchServer::FindTopDocuments(const PreparedQuery& query, const SearchOptions& options) const {
+	return FindTopDocumentsWithOptions(ResolveQuery(query), options);
+}
+
+future<SearchResult> SearchServer::FindTopDocumentsAsync(PreparedQuery query, SearchOptions options) const {
+	return ThreadPool::GetDefault().Submit([this, query = move(query), options] {
+		return FindTopDocuments(query, options);
+	});
+}
+
+SearchResult SearchServer::FindTopDocumentsWithOptions(Query&& query, const SearchOptions& options) const {
+	const QueryDeadline deadline(options.deadline);
+	if (options.deadline != chrono::steady_clock::time_point::max()) {
+		query.deadline = &deadline;
+	}
+
+	TopDocumentsCollector collector(options.max_document_count);
+	const DocumentStatus status = options.status;
+	FindAllDocuments(execution::seq, query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, collector);
+
+	return {move(collector).Extract(), deadline.WasReached()};
+}
+
+QueryDeadline::QueryDeadline(chrono::steady_clock::time_point time)
+: time_(time)
+{
+}
+
+bool QueryDeadline::IsExpired() const {
+	if (is_reached_.load(memory_order_relaxed)) {
+		return true;
+	}
+	if (chrono::steady_clock::now() < time_) {
+		return false;
+	}
+	is_reached_.store(true, memory_order_relaxed);
+	return true;
+}
+
+bool QueryDeadline::WasReached() const {
+	return is_reached_.load(memory_order_relaxed);
+}
+
+void SearchServer::SetResultCacheCapacity(size_t capacity) {
+	result_cache_ = ResultCache(capacity);
+}
+
+ResultCacheStats SearchServer::GetResultCacheStats() const {
+	return result_cache_.GetStats();
+}
+
+string SearchServer::MakeResultCacheKey(const Query& query, DocumentStatus status, size_t max_document_count) {
+	// управляющие символы не встречаются в словах, поэтому годятся в разделители
+	string key = to_string(static_cast<int>(status)) + '\x01' + to_string(max_document_count);
+	for (const QueryTerm& term : query.plus_terms) {
+		key += '\x02';
+		key += term.word;
+	}
+	for (const QueryTerm& term : query.minus_terms) {
+		key += '\x03';
+		key += term.word;
+	}
+	return key;
+}
+
 int SearchServer::GetDocumentCount() const {
-	return documents_.size();
+	return document_ordinals_.size();
+}
+
+size_t SearchServer::GetPostingsMemoryUsage() const {
+	size_t memory_usage = 0;
+	for (const PostingList& postings : term_postings_) {
+		memory_usage += postings.GetMemoryUsage();
+	}
+	return memory_usage;
+}
+
+bool SearchServer::HasDocument(int document_id) const {
+	return document_ordinals_.count(document_id) > 0;
+}
+
+CollectionStatistics SearchServer::GetCollectionStatistics(string_view raw_query) const {
+	CollectionStatistics statistics;
+	statistics.document_count = GetDocumentCount();
+	for (const QueryTerm& term : ParseQuery(raw_query).plus_terms) {
+		statistics.document_freqs.emplace(term.word,
+				term.term_id == TermDictionary::NO_TERM ? 0 : term_document_counts_[term.term_id]);
+	}
+	return statistics;
 }
 
-const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-	static const map<string_view, double> empty_map;
+CollectionStatistics& CollectionStatistics::operator+=(const CollectionStatistics& other) {
+	document_count += other.document_count;
+	for (const auto& [word, document_freq] : other.document_freqs) {
+		document_freqs[word] += document_freq;
+	}
+	return *this;
+}
 
-	if (!document_to_word_freqs_.count(document_id)) {
-		return empty_map;
+CollectionStatistics& CollectionStatistics::operator-=(const CollectionStatistics& other) {
+	document_count -= other.document_count;
+	for (const auto& [word, document_freq] : other.document_freqs) {
+		document_freqs[word] -= document_freq;
 	}
+	return *this;
+}
 
-	return document_to_word_freqs_.at(document_id);
+map<string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+	map<string_view, double> word_freqs;
+
+	const auto it = document_to_term_freqs_.find(document_id);
+	if (it == document_to_term_freqs_.end()) {
+		return word_freqs;
+	}
+
+	for (const auto [term_id, freq] : it->second) {
+		word_freqs.emplace(terms_.GetTerm(term_id), freq);
+	}
+	return word_freqs;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
@@ -89,45 +485,414 @@ void SearchServer::RemoveDocument(int document_id) {
 
 void SearchServer::RemoveDocument(const execution::sequenced_policy&, int document_id) {
 	// если пытаемся удалить ID, который не добавляли на сервер
-	if (!count(document_ids_.begin(), document_ids_.end(), document_id) ) {
+	const auto document_it = document_ordinals_.find(document_id);
+	if (document_it == document_ordinals_.end()) {
 		return;
 	}
 
-	for (auto& [word, freqs] : document_to_word_freqs_.at(document_id)) {
-		auto& document_freqs = word_to_document_freqs_.at(string(word));
-		document_freqs.erase(document_id);
-	}
-
-	document_to_word_freqs_.erase(document_id);
-	documents_.erase(document_id);
-	document_ids_.remove(document_id);
+	MarkRemoved(document_it);
+	CompactIfNeeded();
 }
 
 void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
-	// если пытаемся удалить ID, который не добавляли на сервер
-	if (!count(document_ids_.begin(), document_ids_.end(), document_id) ) {
+	// удаление лишь помечает документ, распараллеливать здесь нечего
+	RemoveDocument(execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocuments(const vector<int>& document_ids) {
+	for (const int document_id : document_ids) {
+		const auto document_it = document_ordinals_.find(document_id);
+		if (document_it != document_ordinals_.end()) {
+			MarkRemoved(document_it);
+		}
+	}
+	CompactIfNeeded();
+}
+
+void SearchServer::Compact() {
+	if (removed_document_count_ == 0) {
 		return;
 	}
 
-	const auto& word_freqs = document_to_word_freqs_.at(document_id);
-	vector<string_view> words(word_freqs.size());
-	transform(
-			execution::par,
-			word_freqs.begin(), word_freqs.end(),
-			words.begin(),
-			[](const auto& item) { return item.first; }
-			);
-	for_each(
-			execution::par,
-			words.begin(), words.end(),
-			[this, document_id] (string_view word) {
-					word_to_document_freqs_.at(string(word)).erase(document_id);
-				}
-			);
+	// живые документы получают новые номера подряд, сохраняя порядок добавления
+	vector<uint32_t> new_ordinals(ordinal_to_document_id_.size(), PostingList::NO_ORDINAL);
+	uint32_t new_ordinal = 0;
+	for (uint32_t ordinal = 0; ordinal < ordinal_to_document_id_.size(); ++ordinal) {
+		const int document_id = ordinal_to_document_id_[ordinal];
+		if (document_id != REMOVED_DOCUMENT_ID) {
+			new_ordinals[ordinal] = new_ordinal;
+			// новый номер не больше старого, поэтому столбцы сжимаются на месте
+			ordinal_to_document_id_[new_ordinal] = document_id;
+			document_ratings_[new_ordinal] = document_ratings_[ordinal];
+			document_statuses_[new_ordinal] = document_statuses_[ordinal];
+			document_inv_word_counts_[new_ordinal] = document_inv_word_counts_[ordinal];
+			document_ordinals_.at(document_id) = new_ordinal;
+			++new_ordinal;
+		}
+	}
+	ordinal_to_document_id_.resize(new_ordinal);
+	document_ratings_.resize(new_ordinal);
+	document_statuses_.resize(new_ordinal);
+	document_inv_word_counts_.resize(new_ordinal);
+
+	ThreadPool::GetDefault().ParallelFor(term_postings_.size(), [this, &new_ordinals](size_t term_id) {
+		term_postings_[term_id].RemapOrdinals(new_ordinals);
+	});
+
+	removed_document_count_ = 0;
+}
+
+void SearchServer::Merge(const SearchServer& other, const unordered_set<int>& excluded_ids) {
+	for (const int document_id : other) {
+		if (excluded_ids.count(document_id) == 0 && document_ordinals_.count(document_id) > 0) {
+			throw invalid_argument("Invalid document_id"s);
+		}
+	}
+
+	version_ = NextVersion();
+	// номера документов other продолжают номера этого индекса
+	vector<uint32_t> new_ordinals(other.ordinal_to_document_id_.size(), PostingList::NO_ORDINAL);
+	vector<double> inv_word_counts(other.ordinal_to_document_id_.size());
+	for (uint32_t ordinal = 0; ordinal < other.ordinal_to_document_id_.size(); ++ordinal) {
+		const int document_id = other.ordinal_to_document_id_[ordinal];
+		if (document_id == REMOVED_DOCUMENT_ID || excluded_ids.count(document_id) > 0) {
+			continue;
+		}
+		inv_word_counts[ordinal] = other.document_inv_word_counts_[ordinal];
+		new_ordinals[ordinal] = AppendDocument(document_id, other.document_ratings_[ordinal],
+				other.GetDocumentStatus(ordinal), inv_word_counts[ordinal]);
+	}
+
+	vector<TermId> new_term_ids(other.terms_.size(), TermDictionary::NO_TERM);
+	for (TermId term_id = 0; term_id < other.terms_.size(); ++term_id) {
+		if (other.term_document_counts_[term_id] == 0) {
+			continue;
+		}
+		const TermId new_term_id = terms_.Intern(other.terms_.GetTerm(term_id));
+		new_term_ids[term_id] = new_term_id;
+		term_postings_.resize(terms_.size());
+		term_document_counts_.resize(terms_.size());
+		other.term_postings_[term_id].ForEach([&](const Posting& posting) {
+			const uint32_t ordinal = new_ordinals[posting.ordinal];
+			if (ordinal != PostingList::NO_ORDINAL) {
+				term_postings_[new_term_id].Append(ordinal, posting.term_count,
+						posting.term_count * inv_word_counts[posting.ordinal]);
+				++term_document_counts_[new_term_id];
+			}
+		});
+	}
 
-	document_to_word_freqs_.erase(document_id);
-	documents_.erase(document_id);
-	document_ids_.remove(document_id);
+	for (const auto& [document_id, term_freqs] : other.document_to_term_freqs_) {
+		if (excluded_ids.count(document_id) > 0) {
+			continue;
+		}
+		auto& new_term_freqs = document_to_term_freqs_[document_id];
+		for (const auto [term_id, term_freq] : term_freqs) {
+			new_term_freqs.emplace(new_term_ids[term_id], term_freq);
+		}
+	}
+}
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'R', 'V', 'S', 'N', 'A', 'P', '\0'};
+
+struct SnapshotHeader {
+	char magic[8];
+	uint32_t format_version;
+	uint32_t reserved;
+	uint64_t payload_size;
+	uint64_t checksum;
+};
+
+} // namespace
+
+void SearchServer::SaveSnapshot(const string& path) const {
+	BinaryWriter writer;
+	writer.Write<uint64_t>(stop_words_.size());
+	for (const string& word : stop_words_) {
+		writer.WriteString(word);
+	}
+	writer.Write<uint64_t>(terms_.size());
+	for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+		writer.WriteString(terms_.GetTerm(term_id));
+	}
+	writer.WriteVector(term_document_counts_);
+	for (const PostingList& postings : term_postings_) {
+		postings.SaveTo(writer);
+	}
+	writer.WriteVector(ordinal_to_document_id_);
+	writer.Write<uint64_t>(removed_document_count_);
+
+	// данные и прямой индекс живых документов по порядку номеров, столбцами
+	vector<int> ratings;
+	vector<DocumentStatus> statuses;
+	vector<double> inv_word_counts;
+	vector<uint32_t> document_term_counts;
+	vector<TermId> document_term_ids;
+	vector<double> document_term_freqs;
+	for (uint32_t ordinal = 0; ordinal < ordinal_to_document_id_.size(); ++ordinal) {
+		const int document_id = ordinal_to_document_id_[ordinal];
+		if (document_id == REMOVED_DOCUMENT_ID) {
+			continue;
+		}
+		ratings.push_back(document_ratings_[ordinal]);
+		statuses.push_back(GetDocumentStatus(ordinal));
+		inv_word_counts.push_back(document_inv_word_counts_[ordinal]);
+		const auto& term_freqs = document_to_term_freqs_.at(document_id);
+		document_term_counts.push_back(static_cast<uint32_t>(term_freqs.size()));
+		for (const auto [term_id, term_freq] : term_freqs) {
+			document_term_ids.push_back(term_id);
+			document_term_freqs.push_back(term_freq);
+		}
+	}
+	writer.WriteVector(ratings);
+	writer.WriteVector(statuses);
+	writer.WriteVector(inv_word_counts);
+	writer.WriteVector(document_term_counts);
+	writer.WriteVector(document_term_ids);
+	writer.WriteVector(document_term_freqs);
+
+	const string_view payload = writer.GetData();
+	SnapshotHeader header{};
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.format_version = SNAPSHOT_FORMAT_VERSION;
+	header.payload_size = payload.size();
+	header.checksum = ComputeChecksum(payload);
+
+	WriteFileAtomically(path, {reinterpret_cast<const char*>(&header), sizeof(header)}, payload);
+}
+
+SearchServer SearchServer::LoadSnapshot(const string& path) {
+	ifstream input(path, ios::binary);
+	if (!input) {
+		throw runtime_error("Failed to open snapshot "s + path);
+	}
+	SnapshotHeader header;
+	if (!input.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+		throw runtime_error("File "s + path + " is not a search server snapshot"s);
+	}
+	if (header.format_version != SNAPSHOT_FORMAT_VERSION) {
+		throw runtime_error("Unsupported snapshot format version "s + to_string(header.format_version));
+	}
+	const auto check = [&path](bool condition) {
+		if (!condition) {
+			throw runtime_error("Snapshot "s + path + " is corrupted"s);
+		}
+	};
+	check(header.payload_size == filesystem::file_size(path) - sizeof(header));
+	string payload(header.payload_size, '\0');
+	input.read(payload.data(), payload.size());
+	check(input && ComputeChecksum(payload) == header.checksum);
+
+	BinaryReader reader(payload);
+	SearchServer server;
+	const uint64_t stop_word_count = reader.Read<uint64_t>();
+	for (uint64_t i = 0; i < stop_word_count; ++i) {
+		server.stop_words_.emplace(reader.ReadString());
+	}
+	const uint64_t term_count = reader.Read<uint64_t>();
+	for (uint64_t i = 0; i < term_count; ++i) {
+		server.terms_.Intern(reader.ReadString());
+	}
+	check(server.terms_.size() == term_count);
+	server.term_document_counts_ = reader.ReadVector<uint32_t>();
+	check(server.term_document_counts_.size() == term_count);
+	server.term_postings_.reserve(term_count);
+	for (uint64_t i = 0; i < term_count; ++i) {
+		server.term_postings_.push_back(PostingList::LoadFrom(reader));
+	}
+	server.ordinal_to_document_id_ = reader.ReadVector<int>();
+	server.removed_document_count_ = reader.Read<uint64_t>();
+
+	const auto ratings = reader.ReadVector<int>();
+	const auto statuses = reader.ReadVector<DocumentStatus>();
+	const auto inv_word_counts = reader.ReadVector<double>();
+	const auto document_term_counts = reader.ReadVector<uint32_t>();
+	const auto document_term_ids = reader.ReadVector<TermId>();
+	const auto document_term_freqs = reader.ReadVector<double>();
+	check(reader.IsEnd());
+	const size_t document_count = server.ordinal_to_document_id_.size() - server.removed_document_count_;
+	check(server.removed_document_count_ <= server.ordinal_to_document_id_.size()
+			&& ratings.size() == document_count && statuses.size() == document_count
+			&& inv_word_counts.size() == document_count && document_term_counts.size() == document_count
+			&& document_term_ids.size() == document_term_freqs.size());
+
+	// в снимке данные только живых документов, у удалённых столбцы заполняются нулями
+	const size_t ordinal_count = server.ordinal_to_document_id_.size();
+	server.document_ordinals_.reserve(document_count);
+	server.document_ratings_.resize(ordinal_count);
+	server.document_statuses_.resize(ordinal_count);
+	server.document_inv_word_counts_.resize(ordinal_count);
+	size_t index = 0;
+	size_t term_offset = 0;
+	for (uint32_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+		const int document_id = server.ordinal_to_document_id_[ordinal];
+		if (document_id == REMOVED_DOCUMENT_ID) {
+			continue;
+		}
+		check(index < document_count && document_term_counts[index] <= document_term_ids.size() - term_offset);
+		const bool inserted = server.document_ordinals_.emplace(document_id, ordinal).second;
+		check(inserted);
+		server.document_ratings_[ordinal] = ratings[index];
+		server.document_statuses_[ordinal] = static_cast<uint8_t>(statuses[index]);
+		server.document_inv_word_counts_[ordinal] = inv_word_counts[index];
+		auto& term_freqs = server.document_to_term_freqs_[document_id];
+		for (uint32_t i = 0; i < document_term_counts[index]; ++i, ++term_offset) {
+			check(document_term_ids[term_offset] < term_count);
+			term_freqs.emplace_hint(term_freqs.end(), document_term_ids[term_offset], document_term_freqs[term_offset]);
+		}
+		++index;
+	}
+	check(index == document_count && term_offset == document_term_ids.size());
+
+	if (document_count > 0) {
+		server.version_ = NextVersion();
+	}
+	return server;
+}
+
+void SearchServer::SaveMappedIndex(const string& path) const {
+	// номера живых документов сжимаются подряд с сохранением порядка
+	vector<uint32_t> new_ordinals(ordinal_to_document_id_.size(), PostingList::NO_ORDINAL);
+	vector<int32_t> document_ids;
+	vector<int32_t> ratings;
+	vector<uint8_t> statuses;
+	vector<double> inv_word_counts;
+	document_ids.reserve(document_ordinals_.size());
+	for (uint32_t ordinal = 0; ordinal < ordinal_to_document_id_.size(); ++ordinal) {
+		const int document_id = ordinal_to_document_id_[ordinal];
+		if (document_id == REMOVED_DOCUMENT_ID) {
+			continue;
+		}
+		new_ordinals[ordinal] = static_cast<uint32_t>(document_ids.size());
+		document_ids.push_back(document_id);
+		ratings.push_back(document_ratings_[ordinal]);
+		statuses.push_back(document_statuses_[ordinal]);
+		inv_word_counts.push_back(document_inv_word_counts_[ordinal]);
+	}
+	vector<MappedIndexDocumentId> id_to_ordinal;
+	id_to_ordinal.reserve(document_ids.size());
+	for (uint32_t ordinal = 0; ordinal < document_ids.size(); ++ordinal) {
+		id_to_ordinal.push_back({document_ids[ordinal], ordinal});
+	}
+	sort(id_to_ordinal.begin(), id_to_ordinal.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.document_id < rhs.document_id;
+	});
+
+	// в файл попадают только слова живых документов, по возрастанию
+	vector<TermId> term_ids;
+	for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+		if (term_document_counts_[term_id] > 0) {
+			term_ids.push_back(term_id);
+		}
+	}
+	sort(term_ids.begin(), term_ids.end(), [this](TermId lhs, TermId rhs) {
+		return terms_.GetTerm(lhs) < terms_.GetTerm(rhs);
+	});
+	vector<uint64_t> term_offsets{0};
+	string term_chars;
+	vector<MappedIndexTerm> terms;
+	vector<PostingList::Block> blocks;
+	vector<uint8_t> posting_data;
+	for (const TermId term_id : term_ids) {
+		term_chars += terms_.GetTerm(term_id);
+		term_offsets.push_back(term_chars.size());
+
+		PostingList remapped;
+		const PostingList* postings = &term_postings_[term_id];
+		if (removed_document_count_ > 0) {
+			remapped = *postings;
+			remapped.RemapOrdinals(new_ordinals);
+			postings = &remapped;
+		}
+		terms.push_back({blocks.size(), posting_data.size(), postings->GetData().size(),
+				static_cast<uint32_t>(postings->GetBlocks().size()), term_document_counts_[term_id],
+				static_cast<float>(postings->GetMaxTermFreq()), 0});
+		blocks.insert(blocks.end(), postings->GetBlocks().begin(), postings->GetBlocks().end());
+		posting_data.insert(posting_data.end(), postings->GetData().begin(), postings->GetData().end());
+	}
+
+	vector<uint64_t> stop_word_offsets{0};
+	string stop_word_chars;
+	for (const string& word : stop_words_) {
+		stop_word_chars += word;
+		stop_word_offsets.push_back(stop_word_chars.size());
+	}
+
+	// смещения секций отсчитываются от начала файла, то есть с учётом заголовка
+	BinaryWriter writer;
+	const auto write_section = [&writer](const void* data, size_t size) {
+		static const char padding[MAPPED_INDEX_ALIGNMENT] = {};
+		const size_t position = sizeof(MappedIndexHeader) + writer.GetData().size();
+		writer.WriteBytes(padding, (MAPPED_INDEX_ALIGNMENT - position % MAPPED_INDEX_ALIGNMENT) % MAPPED_INDEX_ALIGNMENT);
+		const MappedIndexSection section{sizeof(MappedIndexHeader) + writer.GetData().size(), size};
+		writer.WriteBytes(data, size);
+		return section;
+	};
+	const auto write_vector = [&write_section](const auto& values) {
+		return write_section(values.data(), values.size() * sizeof(values[0]));
+	};
+	MappedIndexHeader header{};
+	memcpy(header.magic, MAPPED_INDEX_MAGIC, sizeof(header.magic));
+	header.format_version = MAPPED_INDEX_FORMAT_VERSION;
+	header.document_count = document_ids.size();
+	header.term_count = term_ids.size();
+	header.stop_word_count = stop_words_.size();
+	header.stop_word_offsets = write_vector(stop_word_offsets);
+	header.stop_word_chars = write_vector(stop_word_chars);
+	header.term_offsets = write_vector(term_offsets);
+	header.term_chars = write_vector(term_chars);
+	header.terms = write_vector(terms);
+	header.blocks = write_vector(blocks);
+	header.posting_data = write_vector(posting_data);
+	header.document_ids = write_vector(document_ids);
+	header.ratings = write_vector(ratings);
+	header.statuses = write_vector(statuses);
+	header.inv_word_counts = write_vector(inv_word_counts);
+	header.id_to_ordinal = write_vector(id_to_ordinal);
+	header.file_size = sizeof(header) + writer.GetData().size();
+
+	WriteFileAtomically(path, {reinterpret_cast<const char*>(&header), sizeof(header)}, writer.GetData());
+}
+
+uint64_t SearchServer::NextVersion() {
+	static atomic<uint64_t> last_version = 0;
+	return last_version.fetch_add(1, memory_order_relaxed) + 1;
+}
+
+uint32_t SearchServer::AppendDocument(int document_id, int rating, DocumentStatus status, double inv_word_count) {
+	const uint32_t ordinal = static_cast<uint32_t>(ordinal_to_document_id_.size());
+	document_ordinals_.emplace(document_id, ordinal);
+	ordinal_to_document_id_.push_back(document_id);
+	document_ratings_.push_back(rating);
+	document_statuses_.push_back(static_cast<uint8_t>(status));
+	document_inv_word_counts_.push_back(inv_word_count);
+	return ordinal;
+}
+
+void SearchServer::MarkRemoved(unordered_map<int, uint32_t>::iterator document_it) {
+	const int document_id = document_it->first;
+	const uint32_t ordinal = document_it->second;
+
+	// вхождения остаются в списках до сжатия, но IDF считается по живым документам
+	for (const auto [term_id, _] : document_to_term_freqs_.at(document_id)) {
+		--term_document_counts_[term_id];
+	}
+
+	document_to_term_freqs_.erase(document_id);
+	document_ordinals_.erase(document_it);
+	ordinal_to_document_id_[ordinal] = REMOVED_DOCUMENT_ID;
+	++removed_document_count_;
+	version_ = NextVersion();
+}
+
+void SearchServer::CompactIfNeeded() {
+	if (removed_document_count_ >= COMPACTION_MIN_REMOVED_COUNT
+			&& removed_document_count_ > ordinal_to_document_id_.size() * COMPACTION_REMOVED_RATIO) {
+		Compact();
+	}
 }
 
 tuple<vector<string_view>, DocumentStatus>
@@ -137,62 +902,144 @@ SearchServer::MatchDocument(string_view raw_query, int document_id) const {
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
 		const execution::sequenced_policy&, string_view raw_query, int document_id) const {
-	if (!count(document_ids_.begin(), document_ids_.end(), document_id) ) {
-		throw out_of_range("No documents with id " + document_id);
+	return MatchQuery(execution::seq, ParseQuery(raw_query), document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
+		const execution::parallel_policy&, string_view raw_query, int document_id) const {
+	return MatchQuery(execution::par, ParseQuery(raw_query), document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const PreparedQuery& query,
+		int document_id) const {
+	return MatchDocument(execution::seq, query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
+		const execution::sequenced_policy&, const PreparedQuery& query, int document_id) const {
+	return MatchQuery(execution::seq, ResolveQuery(query), document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
+		const execution::parallel_policy&, const PreparedQuery& query, int document_id) const {
+	return MatchQuery(execution::par, ResolveQuery(query), document_id);
+}
+
+vector<tuple<vector<string_view>, DocumentStatus>> SearchServer::MatchDocuments(
+		const PreparedQuery& prepared_query, const vector<int>& document_ids) const {
+	const Query query = ResolveQuery(prepared_query);
+
+	vector<tuple<vector<string_view>, DocumentStatus>> results;
+	results.reserve(document_ids.size());
+	// внутренние номера документов и их места в результате
+	vector<pair<uint32_t, size_t>> ordinals;
+	ordinals.reserve(document_ids.size());
+	for (const int document_id : document_ids) {
+		const auto document_it = document_ordinals_.find(document_id);
+		if (document_it == document_ordinals_.end()) {
+			throw out_of_range("No documents with id "s + to_string(document_id));
+		}
+		ordinals.emplace_back(document_it->second, results.size());
+		results.emplace_back(vector<string_view>{}, GetDocumentStatus(document_it->second));
+	}
+	sort(ordinals.begin(), ordinals.end());
+
+	const auto for_each_containing = [this, &ordinals](TermId term_id, auto func) {
+		PostingList::Cursor cursor(term_postings_[term_id]);
+		for (const auto& [ordinal, index] : ordinals) {
+			cursor.NextGEQ(ordinal);
+			if (cursor.IsEnd()) {
+				return;
+			}
+			if (cursor.Get().ordinal == ordinal) {
+				func(index);
+			}
+		}
+	};
+
+	vector<bool> is_rejected(document_ids.size());
+	for (const QueryTerm& term : query.minus_terms) {
+		if (term.term_id != TermDictionary::NO_TERM) {
+			for_each_containing(term.term_id, [&is_rejected](size_t index) {
+				is_rejected[index] = true;
+			});
+		}
+	}
+	// возвращаемые string_view ссылаются на словарь сервера, а не на запрос
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
+			continue;
+		}
+		const string_view word = terms_.GetTerm(term.term_id);
+		for_each_containing(term.term_id, [&](size_t index) {
+			if (!is_rejected[index]) {
+				get<0>(results[index]).push_back(word);
+			}
+		});
+	}
+	return results;
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchQuery(
+		const execution::sequenced_policy&, const Query& query, int document_id) const {
+	const auto document_it = document_ordinals_.find(document_id);
+	if (document_it == document_ordinals_.end()) {
+		throw out_of_range("No documents with id "s + to_string(document_id));
 	}
-	auto& status = documents_.at(document_id).status;
-	const auto query = ParseQuery(raw_query);
+	const uint32_t ordinal = document_it->second;
+	const DocumentStatus status = GetDocumentStatus(ordinal);
 
+	// возвращаемые string_view ссылаются на словарь сервера, а не на raw_query
 	vector<string_view> matched_words;
-	for (const string_view word_view : query.minus_words) {
-		string word(word_view);
-		if (word_to_document_freqs_.count(word) == 0) {
+	for (const QueryTerm& term : query.minus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
 			continue;
 		}
-		if (word_to_document_freqs_.at(word).count(document_id)) {
+		if (term_postings_[term.term_id].Contains(ordinal)) {
 			return make_tuple(matched_words, status);
 		}
 	}
-	for (const string_view word_view : query.plus_words) {
-		string word(word_view);
-		if (word_to_document_freqs_.count(word) == 0) {
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
 			continue;
 		}
-		if (word_to_document_freqs_.at(word).count(document_id)) {
-			matched_words.push_back(word_view);
+		if (term_postings_[term.term_id].Contains(ordinal)) {
+			matched_words.push_back(terms_.GetTerm(term.term_id));
 		}
 	}
 	return make_tuple(matched_words, status);
 }
 
-tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
-		const execution::parallel_policy&, string_view raw_query, int document_id) const {
-	if (!count(document_ids_.begin(), document_ids_.end(), document_id) ) {
-		throw out_of_range("No documents with id " + document_id);
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchQuery(
+		const execution::parallel_policy&, const Query& query, int document_id) const {
+	const auto document_it = document_ordinals_.find(document_id);
+	if (document_it == document_ordinals_.end()) {
+		throw out_of_range("No documents with id "s + to_string(document_id));
 	}
-	auto& status = documents_.at(document_id).status;
-	const auto query = ParseQuery(raw_query);
+	const uint32_t ordinal = document_it->second;
+	const DocumentStatus status = GetDocumentStatus(ordinal);
 
 	vector<string_view> matched_words;
 
-	const auto word_checker = [this, document_id] (string_view word_view) {
-		string word(word_view);
-		const auto& item = word_to_document_freqs_.find(word);
-		return item != word_to_document_freqs_.end() && item->second.count(document_id);
+	const auto term_checker = [this, ordinal] (const QueryTerm& term) {
+		return term.term_id != TermDictionary::NO_TERM && term_postings_[term.term_id].Contains(ordinal);
 	};
 
-	if (any_of(query.minus_words.begin(), query.minus_words.end(), word_checker)) {
+	if (any_of(query.minus_terms.begin(), query.minus_terms.end(), term_checker)) {
 		return make_tuple(matched_words, status);
 	}
 
-	matched_words.resize(query.plus_words.size());
-	auto matched_words_end = copy_if(
-			execution::par,
-			query.plus_words.begin(), query.plus_words.end(),
-			matched_words.begin(),
-			word_checker
-			);
-	matched_words.erase(matched_words_end, matched_words.end());
+	// термины проверяются в общем пуле, порядок слов сохраняется при сборе
+	vector<char> is_matched(query.plus_terms.size());
+	ThreadPool::GetDefault().ParallelFor(query.plus_terms.size(), [&](size_t index) {
+		is_matched[index] = term_checker(query.plus_terms[index]);
+	});
+	// возвращаемые string_view ссылаются на словарь сервера, а не на raw_query
+	for (size_t index = 0; index < query.plus_terms.size(); ++index) {
+		if (is_matched[index]) {
+			matched_words.push_back(terms_.GetTerm(query.plus_terms[index].term_id));
+		}
+	}
 
 	return make_tuple(matched_words, status);
 }
@@ -201,23 +1048,19 @@ bool SearchServer::IsStopWord(string_view word) const {
 	return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(string_view word) const {
-	// A valid word must not contain special characters
-	return none_of(word.begin(), word.end(), [](char c) {
-		return c >= '\0' && c < ' ';
-	});
-}
-
 vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
+	// слова выделяются и проверяются за один проход по тексту
 	vector<string_view> words;
-	for (const string_view word : SplitIntoWordsView(text)) {
-		if (!IsValidWord(word)) {
-			throw invalid_argument("Word "s + string(word) + " is invalid"s);
-		}
-		if (!IsStopWord(word)) {
-			words.push_back(word);
-		}
+	const size_t invalid_position = TokenizeWords(text, words);
+	if (invalid_position != text.npos) {
+		const size_t space = text.rfind(' ', invalid_position);
+		const size_t word_begin = space == text.npos ? 0 : space + 1;
+		const size_t word_end = text.find(' ', invalid_position);
+		throw invalid_argument("Word "s + string(text.substr(word_begin, word_end - word_begin)) + " is invalid"s);
 	}
+	words.erase(remove_if(words.begin(), words.end(), [this](string_view word) {
+		return IsStopWord(word);
+	}), words.end());
 	return words;
 }
 
@@ -232,39 +1075,106 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
 	return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
-	if (text.empty()) {
-		throw invalid_argument("Query word is empty"s);
+SearchServer::Query SearchServer::ParseQuery(string_view text, const CollectionStatistics* statistics) const {
+	// типичный запрос разбирается без выделения памяти: слова не копируются,
+	// а списки слов помещаются во встроенный буфер
+	SearchServer::Query result;
+	ForEachWordView(text, [this, &result](string_view word) {
+		const auto query_word = ParseQueryWord(word);
+		if (!IsStopWord(query_word.data)) {
+			auto& terms = query_word.is_minus ? result.minus_terms : result.plus_terms;
+			terms.push_back({query_word.data, TermDictionary::NO_TERM, 0.0});
+		}
+	});
+	for (auto* terms : {&result.plus_terms, &result.minus_terms}) {
+		sort(terms->begin(), terms->end(), [](const QueryTerm& lhs, const QueryTerm& rhs) {
+			return lhs.word < rhs.word;
+		});
+		terms->erase(unique(terms->begin(), terms->end(), [](const QueryTerm& lhs, const QueryTerm& rhs) {
+			return lhs.word == rhs.word;
+		}), terms->end());
+	}
+	ResolveTerms(result, statistics);
+	return result;
+}
+
+SearchServer::Query SearchServer::ResolveQuery(const PreparedQuery& prepared_query) const {
+	Query query;
+	query.plus_terms.reserve(prepared_query.plus_terms_.size());
+	for (const auto& term : prepared_query.plus_terms_) {
+		query.plus_terms.push_back({term.word, term.term_id, term.inverse_document_freq});
+	}
+	query.minus_terms.reserve(prepared_query.minus_terms_.size());
+	for (const auto& term : prepared_query.minus_terms_) {
+		query.minus_terms.push_back({term.word, term.term_id, term.inverse_document_freq});
+	}
+	if (prepared_query.index_version_ != version_) {
+		ResolveTerms(query, nullptr);
 	}
+	return query;
+}
 
-	bool is_minus = false;
-	if (text[0] == '-') {
-		is_minus = true;
-		text.remove_prefix(1);
+void SearchServer::ResolveTerms(Query& query, const CollectionStatistics* statistics) const {
+	for (QueryTerm& term : query.minus_terms) {
+		term.term_id = FindIndexedTerm(term.word);
 	}
-	if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
-		throw invalid_argument("Query word "s + string(text) + " is invalid");
+	for (QueryTerm& term : query.plus_terms) {
+		term.term_id = FindIndexedTerm(term.word);
+		term.inverse_document_freq = term.term_id == TermDictionary::NO_TERM
+				? 0.0
+				: ComputeTermInverseDocumentFreq(term.word, term.term_id, statistics);
 	}
+}
 
-	return {text, is_minus, IsStopWord(text)};
+double SearchServer::ComputeTermInverseDocumentFreq(string_view word, TermId term_id,
+		const CollectionStatistics* statistics) const {
+	if (statistics != nullptr) {
+		const auto it = statistics->document_freqs.find(word);
+		if (it != statistics->document_freqs.end() && it->second > 0) {
+			return log(statistics->document_count * 1.0 / it->second);
+		}
+	}
+	return log(GetDocumentCount() * 1.0 / term_document_counts_[term_id]);
 }
 
-SearchServer::Query SearchServer::ParseQuery(string_view text) const {
-	SearchServer::Query result;
-	for (string_view word : SplitIntoWordsView(text)) {
-		const auto query_word = ParseQueryWord(word);
-		if (!query_word.is_stop) {
-			if (query_word.is_minus) {
-				result.minus_words.emplace(query_word.data);
-			} else {
-				result.plus_words.emplace(query_word.data);
-			}
+vector<uint32_t> SearchServer::SplitOrdinalsByPostings(const Query& query) const {
+	const uint32_t ordinal_count = static_cast<uint32_t>(ordinal_to_document_id_.size());
+
+	// заголовки блоков дают распределение вхождений по номерам без декодирования
+	vector<pair<uint32_t, uint32_t>> blocks;
+	size_t posting_count = 0;
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
+			continue;
 		}
+		term_postings_[term.term_id].ForEachBlock([&blocks, &posting_count](uint32_t first_ordinal, uint32_t count) {
+			blocks.emplace_back(first_ordinal, count);
+			posting_count += count;
+		});
 	}
-	return result;
+
+	// срезы раздаются потокам общего пула, поэтому их число зависит от его размера, а не от числа ядер
+	const size_t max_slice_count = ThreadPool::GetDefault().GetWorkerCount() * 4;
+	const size_t slice_count = clamp<size_t>(posting_count / PARALLEL_MIN_SLICE_POSTINGS, 1, max_slice_count);
+
+	vector<uint32_t> bounds = {0};
+	sort(blocks.begin(), blocks.end());
+	size_t accumulated = 0;
+	for (const auto& [first_ordinal, count] : blocks) {
+		if (accumulated >= posting_count * bounds.size() / slice_count && first_ordinal > bounds.back()) {
+			bounds.push_back(first_ordinal);
+		}
+		accumulated += count;
+	}
+	bounds.push_back(ordinal_count);
+	return bounds;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string& word) const {
-	return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+TermId SearchServer::FindIndexedTerm(string_view word) const {
+	const TermId term_id = terms_.Find(word);
+	if (term_id == TermDictionary::NO_TERM || term_document_counts_[term_id] == 0) {
+		return TermDictionary::NO_TERM;
+	}
+	return term_id;
 }
 
@@ -1,23 +1,53 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <exception>
 #include <execution>
-#include <list>
+#include <future>
+#include <limits>
+#include <iterator>
 #include <map>
+#include <numeric>
 #include <set>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 
-#include "concurrent_map.h"
 #include "document.h"
 #include "log_duration.h"
+#include "posting_list.h"
+#include "result_cache.h"
+#include "score_accumulator.h"
+#include "small_vector.h"
 #include "string_processing.h"
+#include "term_dictionary.h"
+#include "thread_pool.h"
+#include "top_documents_collector.h"
 
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
+// Доля удалённых документов среди всех номеров, при которой индекс сжимается
+const double COMPACTION_REMOVED_RATIO = 0.5;
+const size_t COMPACTION_MIN_REMOVED_COUNT = 1024;
+// По столько документов пакетное добавление разбирает в одной задаче
+const size_t ADD_DOCUMENTS_CHUNK_SIZE = 1024;
+// По столько запросов FindTopDocumentsBatch объединяет в пакет с общими списками вхождений
+const size_t QUERY_BATCH_SIZE = 64;
+// Поиск с отсечением по верхним границам перебирает документы окнами из стольких
+// номеров; между окнами он проверяет срок запроса и пересчитывает обязательные слова
+const size_t MAXSCORE_WINDOW_SIZE = 4096;
+// Меньше стольких вхождений на задачу параллельный поиск не дробит
+const size_t PARALLEL_MIN_SLICE_POSTINGS = 4096;
+// Столько плюс- и столько минус-слов запрос хранит без обращения к куче
+const size_t QUERY_INLINE_TERM_COUNT = 8;
+// Версия формата снимка индекса; меняется при любом изменении формата
+const uint32_t SNAPSHOT_FORMAT_VERSION = 1;
 
 enum class DocumentStatus {
 	ACTUAL,
@@ -26,10 +56,129 @@ enum class DocumentStatus {
 	REMOVED,
 };
 
+// Политика поиска с отсечением по верхним границам релевантности слов и их блоков
+// (MaxScore). Слова, которые вместе не дотягивают до порога выдачи, необязательные:
+// перебираются только документы остальных слов, а вклады необязательных слов
+// добавляются, лишь пока документ ещё может попасть в выдачу. Выгодна, когда нужно
+// немного лучших документов по запросу из слов разной частоты, в том числе длинному.
+struct BlockMaxWandPolicy {
+};
+inline constexpr BlockMaxWandPolicy block_max_wand{};
+
+// Документ для пакетного добавления; текст передаётся во владение серверу
+struct NewDocument {
+	int id;
+	std::string text;
+	DocumentStatus status;
+	std::vector<int> ratings;
+};
+
+// Срок выполнения запроса. Поиск проверяет его между блоками списков вхождений
+// и, если срок прошёл, возвращает лучшие из уже оценённых документов.
+class QueryDeadline {
+public:
+	explicit QueryDeadline(std::chrono::steady_clock::time_point time);
+
+	// Запоминает, что срок прошёл, чтобы остальные потоки запроса не смотрели на часы
+	bool IsExpired() const;
+	// Прерывался ли поиск из-за срока
+	bool WasReached() const;
 
+private:
+	std::chrono::steady_clock::time_point time_;
+	mutable std::atomic<bool> is_reached_ = false;
+};
+
+struct SearchOptions {
+	DocumentStatus status = DocumentStatus::ACTUAL;
+	size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT;
+	// по умолчанию срока нет
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+struct SearchResult {
+	std::vector<Document> documents;
+	// поиск прерван по сроку: документы отобраны по неполным оценкам релевантности,
+	// но минус-слова и статус учтены
+	bool is_truncated = false;
+};
+
+// Статистика коллекции, по которой считается IDF слов запроса. Когда документы
+// разнесены по нескольким индексам, каждый оценивает свои документы по общей
+// статистике, и тогда их выдачи можно объединять.
+struct CollectionStatistics {
+	int document_count = 0;
+	// число документов с каждым плюс-словом запроса
+	std::map<std::string, int, std::less<>> document_freqs;
+
+	CollectionStatistics& operator+=(const CollectionStatistics& other);
+	CollectionStatistics& operator-=(const CollectionStatistics& other);
+};
+
+// Запрос, разобранный один раз для многократного выполнения: слова проверены,
+// стоп-слова и повторы отброшены, слова сопоставлены терминам индекса, для
+// плюс-слов посчитан IDF. Если индекс с тех пор изменился, термины и IDF
+// находятся заново при каждом выполнении, но текст повторно не разбирается.
+class PreparedQuery {
+private:
+	friend class SearchServer;
+
+	struct Term {
+		std::string word;
+		TermId term_id;
+		double inverse_document_freq;
+	};
+	// слова без повторов, по возрастанию
+	std::vector<Term> plus_terms_;
+	std::vector<Term> minus_terms_;
+	// версия индекса, по которой найдены термины и IDF
+	uint64_t index_version_ = 0;
+};
+
+// Пакет документов, тексты которых уже разобраны на слова (PrepareDocuments).
+// Разбор не меняет сервер, поэтому следующий пакет можно готовить, пока
+// предыдущий сливается в индекс.
+class PreparedDocuments {
+public:
+	PreparedDocuments() = default;
+	// слова ссылаются на тексты пакета, поэтому пакет можно только перемещать
+	PreparedDocuments(const PreparedDocuments&) = delete;
+	PreparedDocuments& operator=(const PreparedDocuments&) = delete;
+	PreparedDocuments(PreparedDocuments&&) = default;
+	PreparedDocuments& operator=(PreparedDocuments&&) = default;
+
+	size_t size() const {
+		return documents_.size();
+	}
+
+private:
+	friend class SearchServer;
+
+	// Вхождение слова в документ пакета; word - номер слова в словаре куска,
+	// ordinal - номер документа внутри пакета
+	struct BatchPosting {
+		uint32_t word;
+		uint32_t ordinal;
+		uint32_t term_count;
+	};
+	// Частичный обратный индекс куска пакета: слова куска без повторов и их вхождения,
+	// сгруппированные по слову; вхождения слова words[i] лежат в postings с
+	// word_offsets[i] по word_offsets[i + 1] по возрастанию номера документа
+	struct BatchChunk {
+		std::vector<std::string_view> words;
+		std::vector<uint32_t> word_offsets;
+		std::vector<BatchPosting> postings;
+		std::vector<double> inv_word_counts;
+	};
+
+	std::vector<NewDocument> documents_;
+	std::vector<BatchChunk> chunks_;
+};
 
 class SearchServer {
 public:
+	static constexpr int REMOVED_DOCUMENT_ID = -1;
+
 	SearchServer() = default;
 
 	template <typename StringContainer>
@@ -38,37 +187,182 @@ public:
 	explicit SearchServer(const std::string& stop_words_text);
 
 	void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
-
+	// Добавляет пакет документов: тексты разбираются параллельно кусками по
+	// ADD_DOCUMENTS_CHUNK_SIZE, каждый кусок сортировкой превращается в частичный
+	// обратный индекс, и куски по порядку сливаются в основной индекс.
+	// Результат тот же, что у AddDocument по очереди; при ошибке в любом документе
+	// исключение выбрасывается до изменения сервера.
+	void AddDocuments(std::vector<NewDocument>&& documents);
+	// Первая половина AddDocuments: параллельный разбор текстов без изменения сервера.
+	// Читает только стоп-слова, поэтому может идти одновременно с изменением сервера.
+	PreparedDocuments PrepareDocuments(std::vector<NewDocument>&& documents) const;
+	// Вторая половина: проверка id и слияние разобранного пакета в индекс
+	void AddDocuments(PreparedDocuments&& documents);
+
+	// max_document_count задаёт, сколько лучших документов вернуть
 	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
-	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
 	std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
 	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const;
-	std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentStatus status) const;
+	std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query,
+			DocumentStatus status, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
 	std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query) const;
 
 	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const;
-	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentStatus status) const;
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query,
+			DocumentStatus status, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
 	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query) const;
 
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const BlockMaxWandPolicy&, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const BlockMaxWandPolicy&, std::string_view raw_query,
+			DocumentStatus status, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const BlockMaxWandPolicy&, std::string_view raw_query) const;
+
+	// Выполняет набор запросов сразу, с тем же результатом, что FindTopDocuments для
+	// каждого. Запросы разбираются заранее, повторы выполняются один раз, остальные
+	// упорядочиваются по словам и делятся на пакеты по QUERY_BATCH_SIZE, которые
+	// выполняются параллельно. В пакете список вхождений каждого слова декодируется
+	// и оценивается один раз, а запросы пакета читают готовые оценки.
+	std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string_view>& raw_queries,
+			DocumentStatus status = DocumentStatus::ACTUAL,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	// Поиск со сроком выполнения
+	SearchResult FindTopDocuments(std::string_view raw_query, const SearchOptions& options) const;
+	// То же в общем пуле потоков; сервер должен жить, пока результат не получен
+	std::future<SearchResult> FindTopDocumentsAsync(std::string raw_query, SearchOptions options = {}) const;
+
+	// Разбирает запрос для многократного выполнения. Подготовленный запрос
+	// принимают все методы поиска и сопоставления; выполнять его можно и на
+	// другом сервере с теми же стоп-словами.
+	PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const PreparedQuery& query,
+			DocumentStatus status = DocumentStatus::ACTUAL,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+			DocumentPredicate document_predicate, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	template <typename ExecutionPolicy>
+	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+			DocumentStatus status = DocumentStatus::ACTUAL,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<PreparedQuery>& queries,
+			DocumentStatus status = DocumentStatus::ACTUAL,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	SearchResult FindTopDocuments(const PreparedQuery& query, const SearchOptions& options) const;
+	std::future<SearchResult> FindTopDocumentsAsync(PreparedQuery query, SearchOptions options = {}) const;
+
+	// Поиск, при котором IDF считается по внешней статистике коллекции
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count,
+			const CollectionStatistics& statistics) const;
+
+	// Статистика этого индекса по плюс-словам запроса
+	CollectionStatistics GetCollectionStatistics(std::string_view raw_query) const;
+
+	// Включает кэш результатов поиска по статусу на capacity запросов; 0 выключает кэш.
+	// Ключ - разобранный запрос, статус и число документов, поэтому запросы, которые
+	// отличаются лишь порядком или повтором слов, делят запись. Любое изменение
+	// индекса делает записи устаревшими.
+	void SetResultCacheCapacity(size_t capacity);
+	ResultCacheStats GetResultCacheStats() const;
+
 	int GetDocumentCount() const;
+	bool HasDocument(int document_id) const;
+	// Память, которую занимают списки вхождений обратного индекса
+	size_t GetPostingsMemoryUsage() const;
+
+	// Обходит id документов в порядке добавления, пропуская удалённые
+	class DocumentIdIterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = int;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const int*;
+		using reference = const int&;
+
+		DocumentIdIterator(const int* current, const int* end)
+		: current_(current)
+		, end_(end)
+		{
+			SkipRemoved();
+		}
+
+		reference operator*() const {
+			return *current_;
+		}
+
+		DocumentIdIterator& operator++() {
+			++current_;
+			SkipRemoved();
+			return *this;
+		}
+
+		DocumentIdIterator operator++(int) {
+			DocumentIdIterator result = *this;
+			++*this;
+			return result;
+		}
+
+		bool operator==(const DocumentIdIterator& other) const {
+			return current_ == other.current_;
+		}
+
+		bool operator!=(const DocumentIdIterator& other) const {
+			return current_ != other.current_;
+		}
+
+	private:
+		const int* current_;
+		const int* end_;
+
+		void SkipRemoved() {
+			while (current_ != end_ && *current_ == REMOVED_DOCUMENT_ID) {
+				++current_;
+			}
+		}
+	};
 
-	auto begin() const {
-		return document_ids_.begin();
+	DocumentIdIterator begin() const {
+		const int* data = ordinal_to_document_id_.data();
+		return {data, data + ordinal_to_document_id_.size()};
 	}
 
-	auto end() const {
-		return document_ids_.end();
+	DocumentIdIterator end() const {
+		const int* end = ordinal_to_document_id_.data() + ordinal_to_document_id_.size();
+		return {end, end};
 	}
 
-	const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+	std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
 
 	void RemoveDocument(int document_id);
 	void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
 	void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+	void RemoveDocuments(const std::vector<int>& document_ids);
+
+	// Удаление только помечает документ: его вхождения пропускаются при поиске, пока
+	// сжатие не перепишет списки вхождений. Сжатие запускается само, когда удалённых
+	// документов становится больше COMPACTION_REMOVED_RATIO от всех номеров.
+	void Compact();
+
+	// Дописывает в индекс документы other, кроме excluded_ids, не разбирая тексты заново.
+	// Документы other получают номера после уже добавленных. Стоп-слова должны совпадать.
+	void Merge(const SearchServer& other, const std::unordered_set<int>& excluded_ids = {});
 
 	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
 	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&,
@@ -76,50 +370,138 @@ public:
 	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&,
 				std::string_view raw_query, int document_id) const;
 
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PreparedQuery& query,
+			int document_id) const;
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&,
+			const PreparedQuery& query, int document_id) const;
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&,
+			const PreparedQuery& query, int document_id) const;
+	// Сопоставляет запрос сразу нескольким документам; i-й результат тот же, что у
+	// MatchDocument(query, document_ids[i]). Список вхождений каждого слова запроса
+	// проходится один раз, документы - в порядке внутренних номеров.
+	std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(
+			const PreparedQuery& query, const std::vector<int>& document_ids) const;
+
+	// Снимок индекса в двоичном формате: стоп-слова, словарь, списки вхождений,
+	// прямой индекс, рейтинги и статусы документов. Файл начинается с заголовка
+	// с версией формата и контрольной суммой и записывается через временный файл
+	// со сбросом на диск, поэтому сбой при записи не портит прежний снимок. Загрузка читает файл
+	// целиком и не разбирает тексты заново; для повреждённого или чужого файла
+	// выбрасывается runtime_error. Кэш результатов в снимок не входит.
+	void SaveSnapshot(const std::string& path) const;
+	static SearchServer LoadSnapshot(const std::string& path);
+
+	// Индекс только для чтения в формате MappedSearchServer: плоские выровненные
+	// массивы, которые отображаются в память и читаются без разбора. Удалённые
+	// документы в файл не попадают, а номера живых идут подряд. Прямой индекс
+	// и частоты слов документов не сохраняются.
+	void SaveMappedIndex(const std::string& path) const;
+
 	std::set<std::string, std::less<>> GetStopWords() {
 		return stop_words_;
 	}
 
 private:
-	struct DocumentData {
-		std::string document_data;
-		int rating;
-		DocumentStatus status;
-	};
 	std::set<std::string, std::less<>> stop_words_;
-	std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-	std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-	std::map<int, DocumentData> documents_;
-	std::list<int> document_ids_;
+	TermDictionary terms_;
+	// списки вхождений по id термина; документы в них адресуются внутренними
+	// номерами, которые выдаются по порядку добавления
+	std::vector<PostingList> term_postings_;
+	std::map<int, std::map<TermId, double>> document_to_term_freqs_;
+	// внутренний номер живого документа по id
+	std::unordered_map<int, uint32_t> document_ordinals_;
+	// число живых документов с термином; по нему считается IDF
+	std::vector<uint32_t> term_document_counts_;
+	// Данные документов столбцами по внутреннему номеру: при поиске предикат и
+	// релевантность читают их из плотных массивов, а не ищут документ по id.
+	// У удалённых документов id равен REMOVED_DOCUMENT_ID, остальное остаётся до сжатия.
+	std::vector<int> ordinal_to_document_id_;
+	std::vector<int32_t> document_ratings_;
+	std::vector<uint8_t> document_statuses_;
+	std::vector<double> document_inv_word_counts_;
+	size_t removed_document_count_ = 0;
+	// Версия набора документов: при каждом изменении берётся новая из общего
+	// счётчика, поэтому одинаковые версии бывают только у копий одного индекса.
+	// У пустого индекса версия 0.
+	uint64_t version_ = 0;
+	ResultCache result_cache_;
+
+	static uint64_t NextVersion();
+
+	// Дописывает документ в столбцы и возвращает его внутренний номер
+	uint32_t AppendDocument(int document_id, int rating, DocumentStatus status, double inv_word_count);
+	DocumentStatus GetDocumentStatus(uint32_t ordinal) const {
+		return static_cast<DocumentStatus>(document_statuses_[ordinal]);
+	}
+
+	void MarkRemoved(std::unordered_map<int, uint32_t>::iterator document_it);
+	void CompactIfNeeded();
 
 	bool IsStopWord(std::string_view word) const;
-	bool IsValidWord(std::string_view word) const;
 
 	std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
 	int ComputeAverageRating(const std::vector<int>& ratings);
 
-	struct QueryWord {
-		std::string_view data;
-		bool is_minus;
-		bool is_stop;
+	// Слово запроса и его термин; NO_TERM, если слова нет ни в одном документе
+	struct QueryTerm {
+		std::string_view word;
+		TermId term_id;
+		double inverse_document_freq;
 	};
-	QueryWord ParseQueryWord(std::string_view text) const;
-
+	using QueryTerms = SmallVector<QueryTerm, QUERY_INLINE_TERM_COUNT>;
 	struct Query {
-		std::set<std::string_view> plus_words;
-		std::set<std::string_view> minus_words;
+		// слова без повторов, по возрастанию
+		QueryTerms plus_terms;
+		QueryTerms minus_terms;
+		const QueryDeadline* deadline = nullptr;
 	};
-	Query ParseQuery(std::string_view text) const;
+	// Если statistics задана, IDF считается по ней, а не по этому индексу
+	Query ParseQuery(std::string_view text, const CollectionStatistics* statistics = nullptr) const;
+	// Термины и IDF подготовленного запроса берутся готовыми, если индекс с тех пор не менялся
+	Query ResolveQuery(const PreparedQuery& prepared_query) const;
+	void ResolveTerms(Query& query, const CollectionStatistics* statistics) const;
+
+	static std::string MakeResultCacheKey(const Query& query, DocumentStatus status, size_t max_document_count);
+
+	// Поиск по статусу с обращением к кэшу результатов
+	template <typename ExecutionPolicy>
+	std::vector<Document> FindTopDocumentsByStatus(const ExecutionPolicy& policy, const Query& query,
+			DocumentStatus status, size_t max_document_count) const;
+	std::vector<std::vector<Document>> FindTopDocumentsBatch(std::vector<Query>&& queries,
+			DocumentStatus status, size_t max_document_count) const;
+	SearchResult FindTopDocumentsWithOptions(Query&& query, const SearchOptions& options) const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchQuery(const std::execution::sequenced_policy&,
+			const Query& query, int document_id) const;
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchQuery(const std::execution::parallel_policy&,
+			const Query& query, int document_id) const;
 
 	// Existence required
-	double ComputeWordInverseDocumentFreq(const std::string& word) const;
+	double ComputeTermInverseDocumentFreq(std::string_view word, TermId term_id,
+			const CollectionStatistics* statistics) const;
+
+	// Возвращает NO_TERM для слов, которых нет ни в одном документе
+	TermId FindIndexedTerm(std::string_view word) const;
+
+	// Границы отрезков внутренних номеров для параллельного поиска: от 0 до числа номеров,
+	// отрезки содержат примерно поровну вхождений плюс-слов запроса
+	std::vector<uint32_t> SplitOrdinalsByPostings(const Query& query) const;
+
+	// Считает релевантность документов с номерами из [first_ordinal, last_ordinal)
+	template <typename DocumentPredicate>
+	void AccumulateRelevance(const Query& query, DocumentPredicate document_predicate,
+			uint32_t first_ordinal, uint32_t last_ordinal, ScoreAccumulator& accumulator) const;
 
+	// Передаёт все документы, подходящие под запрос, в collector
 	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+	void FindAllDocuments(const std::execution::sequenced_policy&, const Query& query,
+			DocumentPredicate document_predicate, TopDocumentsCollector& collector) const;
 	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const;
+	void FindAllDocuments(const std::execution::parallel_policy&, const Query& query,
+			DocumentPredicate document_predicate, TopDocumentsCollector& collector) const;
 	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const;
+	void FindAllDocuments(const BlockMaxWandPolicy&, const Query& query,
+			DocumentPredicate document_predicate, TopDocumentsCollector& collector) const;
 };
 
 template <typename StringContainer>
@@ -135,143 +517,318 @@ SearchServer::SearchServer(const StringContainer& stop_words)
 
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
-		DocumentPredicate document_predicate) const {
-	return SearchServer::FindTopDocuments(std::execution::seq, raw_query,document_predicate);
+		DocumentPredicate document_predicate, size_t max_document_count) const {
+	return SearchServer::FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_document_count);
 }
 
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&,
-		std::string_view raw_query, DocumentPredicate document_predicate) const {
-
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
 	const auto& query = ParseQuery(raw_query);
 
-	auto matched_documents = std::move(FindAllDocuments(std::execution::seq, query, document_predicate));
+	TopDocumentsCollector collector(max_document_count);
+	FindAllDocuments(std::execution::seq, query, document_predicate, collector);
 
-	sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-		if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-			return lhs.rating > rhs.rating;
-		} else {
-			return lhs.relevance > rhs.relevance;
-		}
-	});
+	return std::move(collector).Extract();
+}
 
-	if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-		matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-	}
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&,
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
+	const auto& query = ParseQuery(raw_query);
 
-	return matched_documents;
+	TopDocumentsCollector collector(max_document_count);
+	FindAllDocuments(std::execution::par, query, document_predicate, collector);
+
+	return std::move(collector).Extract();
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&,
-		std::string_view raw_query, DocumentPredicate document_predicate) const {
+std::vector<Document> SearchServer::FindTopDocuments(const BlockMaxWandPolicy&,
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
 	const auto& query = ParseQuery(raw_query);
 
-	auto matched_documents = std::move(FindAllDocuments(std::execution::par, query, document_predicate));
+	TopDocumentsCollector collector(max_document_count);
+	FindAllDocuments(block_max_wand, query, document_predicate, collector);
+
+	return std::move(collector).Extract();
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, std::string_view raw_query,
+		DocumentPredicate document_predicate, size_t max_document_count,
+		const CollectionStatistics& statistics) const {
+	const auto query = ParseQuery(raw_query, &statistics);
+
+	TopDocumentsCollector collector(max_document_count);
+	FindAllDocuments(policy, query, document_predicate, collector);
+
+	return std::move(collector).Extract();
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query,
+		DocumentPredicate document_predicate, size_t max_document_count) const {
+	return FindTopDocuments(std::execution::seq, query, document_predicate, max_document_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+		DocumentPredicate document_predicate, size_t max_document_count) const {
+	TopDocumentsCollector collector(max_document_count);
+	FindAllDocuments(policy, ResolveQuery(query), document_predicate, collector);
 
-	sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-		if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-			return lhs.rating > rhs.rating;
-		} else {
-			return lhs.relevance > rhs.relevance;
+	return std::move(collector).Extract();
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+		DocumentStatus status, size_t max_document_count) const {
+	return FindTopDocumentsByStatus(policy, ResolveQuery(query), status, max_document_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsByStatus(const ExecutionPolicy& policy,
+		const Query& query, DocumentStatus status, size_t max_document_count) const {
+	std::string key;
+	if (result_cache_.IsEnabled()) {
+		key = MakeResultCacheKey(query, status, max_document_count);
+		if (auto documents = result_cache_.Find(key, version_)) {
+			return std::move(*documents);
 		}
-	});
-	if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-		matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
 	}
 
-	return matched_documents;
+	TopDocumentsCollector collector(max_document_count);
+	FindAllDocuments(policy, query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, collector);
+	auto documents = std::move(collector).Extract();
+
+	if (result_cache_.IsEnabled()) {
+		result_cache_.Insert(std::move(key), version_, documents);
+	}
+	return documents;
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&,
-		const Query& query, DocumentPredicate document_predicate) const {
-	std::map<int, double> document_to_relevance;
+void SearchServer::AccumulateRelevance(const Query& query, DocumentPredicate document_predicate,
+		uint32_t first_ordinal, uint32_t last_ordinal, ScoreAccumulator& accumulator) const {
+	// документы с минус-словами отбрасываются до подсчёта релевантности
+	for (const QueryTerm& term : query.minus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
+			continue;
+		}
+		term_postings_[term.term_id].ForEachInRange(first_ordinal, last_ordinal,
+				[&accumulator](const Posting& posting) {
+			accumulator.Reject(posting.ordinal);
+		});
+	}
 
-	for (const std::string_view word_view : query.plus_words) {
-		std::string word(word_view);
-		if (!word_to_document_freqs_.count(word) || word_to_document_freqs_.at(word).empty()) {
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
 			continue;
 		}
-		const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-		for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-			const auto& document_data = documents_.at(document_id);
-			if (document_predicate(document_id, document_data.status, document_data.rating)) {
-				document_to_relevance[document_id] += term_freq * inverse_document_freq;
+		const double inverse_document_freq = term.inverse_document_freq;
+		const auto add_postings = [&](const Posting* begin, const Posting* end) {
+			// срок проверяется только здесь: минус-слова обрабатываются всегда целиком
+			if (query.deadline != nullptr && query.deadline->IsExpired()) {
+				return false;
+			}
+			for (const Posting* posting = begin; posting != end; ++posting) {
+				const uint32_t ordinal = posting->ordinal;
+				if (accumulator.IsRejected(ordinal)) {
+					continue;
+				}
+				const int document_id = ordinal_to_document_id_[ordinal];
+				if (document_id == REMOVED_DOCUMENT_ID) {
+					continue;
+				}
+				// предикат вызывается один раз на документ
+				if (!accumulator.IsAccepted(ordinal) && !document_predicate(document_id,
+						GetDocumentStatus(ordinal), document_ratings_[ordinal])) {
+					accumulator.Reject(ordinal);
+					continue;
+				}
+				const double term_freq = posting->term_count * document_inv_word_counts_[ordinal];
+				accumulator.Add(ordinal, term_freq * inverse_document_freq);
 			}
+			return true;
+		};
+		if (!term_postings_[term.term_id].ForEachBlockInRange(first_ordinal, last_ordinal, add_postings)) {
+			return;
 		}
 	}
+}
 
-	for (const std::string_view word_view : query.minus_words) {
-		std::string word(word_view);
-		if (word_to_document_freqs_.count(word) == 0) {
-			continue;
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const std::execution::sequenced_policy&,
+		const Query& query, DocumentPredicate document_predicate, TopDocumentsCollector& collector) const {
+	auto& accumulator = ScoreAccumulator::ForCurrentThread();
+	accumulator.Reset(ordinal_to_document_id_.size());
+	AccumulateRelevance(query, document_predicate, 0, ordinal_to_document_id_.size(), accumulator);
+
+	accumulator.ForEach([&](uint32_t ordinal, double relevance) {
+		collector.Add({ordinal_to_document_id_[ordinal], relevance, document_ratings_[ordinal]});
+	});
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const std::execution::parallel_policy&,
+		const Query& query, DocumentPredicate document_predicate, TopDocumentsCollector& collector) const {
+	// Пространство внутренних номеров делится на отрезки с примерно равным числом
+	// вхождений слов запроса; каждый отрезок целиком обрабатывается одной задачей
+	// в собственном накопителе, поэтому задачам не нужны блокировки, а объединять
+	// приходится только лучшие документы отрезков.
+	const uint32_t ordinal_count = static_cast<uint32_t>(ordinal_to_document_id_.size());
+	const std::vector<uint32_t> bounds = SplitOrdinalsByPostings(query);
+	const uint32_t slice_count = static_cast<uint32_t>(bounds.size() - 1);
+	std::vector<std::vector<Document>> slice_documents(slice_count);
+
+	ThreadPool::GetDefault().ParallelFor(slice_count, [&](size_t slice) {
+		auto& accumulator = ScoreAccumulator::ForCurrentThread();
+		accumulator.Reset(ordinal_count);
+		AccumulateRelevance(query, document_predicate, bounds[slice], bounds[slice + 1], accumulator);
+
+		TopDocumentsCollector slice_collector(collector.GetMaxCount());
+		accumulator.ForEach([&](uint32_t ordinal, double relevance) {
+			slice_collector.Add({ordinal_to_document_id_[ordinal], relevance, document_ratings_[ordinal]});
+		});
+		slice_documents[slice] = std::move(slice_collector).Extract();
+	});
+
+	for (const auto& documents : slice_documents) {
+		for (const Document& document : documents) {
+			collector.Add(document);
 		}
-		for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-			document_to_relevance.erase(document_id);
+	}
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const BlockMaxWandPolicy&,
+		const Query& query, DocumentPredicate document_predicate, TopDocumentsCollector& collector) const {
+	struct TermCursor {
+		const PostingList* postings;
+		PostingList::Cursor cursor;
+		double inverse_document_freq;
+		double max_score;
+	};
+
+	std::vector<TermCursor> term_cursors;
+	term_cursors.reserve(query.plus_terms.size());
+	for (const QueryTerm& term : query.plus_terms) {
+		if (term.term_id == TermDictionary::NO_TERM) {
+			continue;
 		}
+		const auto& postings = term_postings_[term.term_id];
+		term_cursors.push_back({&postings, PostingList::Cursor(postings), term.inverse_document_freq,
+				postings.GetMaxTermFreq() * term.inverse_document_freq});
 	}
 
-	std::vector<Document> matched_documents;
-	matched_documents.reserve(document_to_relevance.size());
-	for (const auto [document_id, relevance] : document_to_relevance) {
-		matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+	std::vector<PostingList::Cursor> minus_cursors;
+	for (const QueryTerm& term : query.minus_terms) {
+		if (term.term_id != TermDictionary::NO_TERM) {
+			minus_cursors.emplace_back(term_postings_[term.term_id]);
+		}
 	}
+	const auto has_minus_word = [&minus_cursors](uint32_t ordinal) {
+		return std::any_of(minus_cursors.begin(), minus_cursors.end(), [ordinal](PostingList::Cursor& cursor) {
+			cursor.NextGEQ(ordinal);
+			return !cursor.IsEnd() && cursor.Get().ordinal == ordinal;
+		});
+	};
 
-	return matched_documents;
-}
+	// слова по возрастанию верхней границы вклада; upper_bounds[i] - сумма границ слов с 0 по i
+	std::vector<TermCursor*> terms;
+	for (auto& term_cursor : term_cursors) {
+		terms.push_back(&term_cursor);
+	}
+	std::sort(terms.begin(), terms.end(), [](const TermCursor* lhs, const TermCursor* rhs) {
+		return lhs->max_score < rhs->max_score;
+	});
+	std::vector<double> upper_bounds(terms.size());
+	double upper_bound = 0.0;
+	for (size_t i = 0; i < terms.size(); ++i) {
+		upper_bound += terms[i]->max_score;
+		upper_bounds[i] = upper_bound;
+	}
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&,
-		const Query& query, DocumentPredicate document_predicate) const {
-	std::vector<std::string_view> words(query.plus_words.size());
-	auto words_end = std::copy_if(
-			std::execution::par,
-			query.plus_words.begin(), query.plus_words.end(),
-			words.begin(),
-			[this](std::string_view word_view) {
-					std::string word(word_view);
-					return word_to_document_freqs_.count(word) && !word_to_document_freqs_.at(word).empty();
+	// Слова до essential_begin необязательные: документ только из них не превысит
+	// порог, поэтому перебираются лишь документы обязательных слов. Граница
+	// пересчитывается в начале каждого окна: порог растёт, и необязательных слов
+	// становится больше.
+	const uint32_t ordinal_count = static_cast<uint32_t>(ordinal_to_document_id_.size());
+	std::vector<double> window_scores(MAXSCORE_WINDOW_SIZE);
+	std::vector<uint64_t> window_mask(MAXSCORE_WINDOW_SIZE / 64);
+	size_t essential_begin = 0;
+	for (uint32_t first_ordinal = 0; first_ordinal < ordinal_count; first_ordinal += MAXSCORE_WINDOW_SIZE) {
+		if (query.deadline != nullptr && query.deadline->IsExpired()) {
+			break;
+		}
+		const double window_threshold = collector.GetEntryThreshold();
+		while (essential_begin < terms.size() && upper_bounds[essential_begin] <= window_threshold) {
+			++essential_begin;
+		}
+		if (essential_begin == terms.size()) {
+			break;
+		}
+		const uint32_t last_ordinal = static_cast<uint32_t>(
+				std::min<size_t>(size_t{first_ordinal} + MAXSCORE_WINDOW_SIZE, ordinal_count));
+
+		// вклады обязательных слов складываются по словам, как при полном переборе
+		for (size_t i = essential_begin; i < terms.size(); ++i) {
+			const double inverse_document_freq = terms[i]->inverse_document_freq;
+			terms[i]->postings->ForEachBlockInRange(first_ordinal, last_ordinal,
+					[&](const Posting* begin, const Posting* end) {
+				for (const Posting* posting = begin; posting != end; ++posting) {
+					const uint32_t offset = posting->ordinal - first_ordinal;
+					const double term_freq = posting->term_count * document_inv_word_counts_[posting->ordinal];
+					window_scores[offset] += term_freq * inverse_document_freq;
+					window_mask[offset / 64] |= uint64_t{1} << (offset % 64);
 				}
-			);
-	words.erase(words_end, words.end());
-	words.erase(std::remove_if(
-			std::execution::par,
-			words.begin(), words.end(),
-			[this, &query](std::string_view word_view) {
-					std::string word(word_view);
-					return word_to_document_freqs_.count(word) && query.minus_words.count(word_view);
+				return true;
+			});
+		}
+
+		// документы окна по возрастанию номеров, чтобы курсоры необязательных слов шли только вперёд
+		for (size_t mask_index = 0; mask_index < window_mask.size(); ++mask_index) {
+			for (uint64_t mask = window_mask[mask_index]; mask != 0; mask &= mask - 1) {
+				const uint32_t offset = static_cast<uint32_t>(mask_index * 64 + __builtin_ctzll(mask));
+				const uint32_t ordinal = first_ordinal + offset;
+				double relevance = window_scores[offset];
+				window_scores[offset] = 0.0;
+
+				const int document_id = ordinal_to_document_id_[ordinal];
+				const double threshold = collector.GetEntryThreshold();
+				if (document_id == REMOVED_DOCUMENT_ID
+						|| (essential_begin > 0 && relevance + upper_bounds[essential_begin - 1] <= threshold)) {
+					continue;
 				}
-			), words.end());
-
-	ConcurrentMap<int, double> document_to_relevance_concurent(101u);
-	std::for_each(
-			std::execution::par,
-			words.begin(), words.end(),
-			[this, document_predicate, &document_to_relevance_concurent] (std::string_view word_view) {
-					std::string word(word_view);
-					const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-					for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-						const auto& document_data = documents_.at(document_id);
-						if (document_predicate(document_id, document_data.status, document_data.rating)) {
-							document_to_relevance_concurent[document_id].ref_to_value += term_freq * inverse_document_freq;
-						}
+				// необязательные слова - от самых весомых, пока документ ещё может превысить
+				// порог; граница блока уточняет границу слова, не декодируя блок
+				bool is_candidate = true;
+				for (size_t i = essential_begin; i-- > 0;) {
+					const double rest_upper_bound = i > 0 ? upper_bounds[i - 1] : 0.0;
+					auto& cursor = terms[i]->cursor;
+					cursor.ShallowSeek(ordinal);
+					if (relevance + cursor.GetBlockMaxTermFreq() * terms[i]->inverse_document_freq
+							+ rest_upper_bound <= threshold) {
+						is_candidate = false;
+						break;
+					}
+					cursor.NextGEQ(ordinal);
+					if (!cursor.IsEnd() && cursor.Get().ordinal == ordinal) {
+						const double term_freq = cursor.Get().term_count * document_inv_word_counts_[ordinal];
+						relevance += term_freq * terms[i]->inverse_document_freq;
 					}
 				}
-			);
-
-	const auto& document_to_relevance_ordinary = document_to_relevance_concurent.BuildOrdinaryMap();
-	std::vector<Document> matched_documents(document_to_relevance_ordinary.size());
-	transform(
-			std::execution::par,
-			document_to_relevance_ordinary.begin(), document_to_relevance_ordinary.end(),
-			matched_documents.begin(),
-			[this](const auto& item) {
-					const int document_id = item.first;
-					const double relevance = item.second;
-					return Document{document_id, relevance, documents_.at(document_id).rating};
-				}
-			);
 
-	return matched_documents;
+				if (is_candidate && relevance > threshold && !has_minus_word(ordinal)
+						&& document_predicate(document_id, GetDocumentStatus(ordinal), document_ratings_[ordinal])) {
+					collector.Add({document_id, relevance, document_ratings_[ordinal]});
+				}
+			}
+			window_mask[mask_index] = 0;
+		}
+	}
 }
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "segmented_search_server.h"
+
+using namespace std;
+
+SegmentedSearchServer::SegmentedSearchServer(const SearchServer& empty_segment, size_t flush_document_count)
+: empty_segment_(empty_segment)
+, flush_document_count_(max<size_t>(flush_document_count, 1))
+, mutable_segment_(empty_segment)
+{
+	if (empty_segment.GetDocumentCount() > 0) {
+		throw invalid_argument("Segment prototype must be empty"s);
+	}
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+	if (pending_merge_) {
+		pending_merge_->result.wait();
+	}
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+		const vector<int>& ratings) {
+	FinishMerge(false);
+	const bool is_frozen = any_of(segments_.begin(), segments_.end(), [document_id](const Segment& segment) {
+		return segment.index->HasDocument(document_id) && segment.removed_ids.count(document_id) == 0;
+	});
+	if (is_frozen) {
+		throw invalid_argument("Invalid document_id"s);
+	}
+
+	mutable_segment_.AddDocument(document_id, document, status, ratings);
+	++document_count_;
+	if (static_cast<size_t>(mutable_segment_.GetDocumentCount()) >= flush_document_count_) {
+		Flush();
+	}
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+	FinishMerge(false);
+	if (mutable_segment_.HasDocument(document_id)) {
+		mutable_segment_.RemoveDocument(document_id);
+		--document_count_;
+		return;
+	}
+
+	for (Segment& segment : segments_) {
+		if (!segment.index->HasDocument(document_id) || !segment.removed_ids.insert(document_id).second) {
+			continue;
+		}
+		for (const auto& [word, _] : segment.index->GetWordFrequencies(document_id)) {
+			++segment.removed_document_freqs[string(word)];
+		}
+		--document_count_;
+		return;
+	}
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status,
+		size_t max_document_count) const {
+	return FindTopDocuments(raw_query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, max_document_count);
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(string_view raw_query) const {
+	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(const execution::parallel_policy&, string_view raw_query,
+		DocumentStatus status, size_t max_document_count) const {
+	return FindTopDocuments(execution::par, raw_query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, max_document_count);
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(const execution::parallel_policy&,
+		string_view raw_query) const {
+	return FindTopDocuments(execution::par, raw_query, DocumentStatus::ACTUAL);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+	return document_count_;
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+	return segments_.size();
+}
+
+void SegmentedSearchServer::Flush() {
+	if (mutable_segment_.GetDocumentCount() == 0) {
+		return;
+	}
+	mutable_segment_.Compact();
+	segments_.push_back({make_shared<const SearchServer>(move(mutable_segment_)), {}, {}});
+	mutable_segment_ = empty_segment_;
+	StartMerge();
+}
+
+void SegmentedSearchServer::WaitForMerge() {
+	// результат слияния может сразу дать повод для следующего
+	while (pending_merge_) {
+		FinishMerge(true);
+	}
+}
+
+size_t SegmentedSearchServer::GetTier(size_t document_count, size_t flush_document_count) {
+	size_t tier = 0;
+	for (size_t tier_size = flush_document_count * SEGMENT_MERGE_FACTOR; document_count >= tier_size;
+			tier_size *= SEGMENT_MERGE_FACTOR) {
+		++tier;
+	}
+	return tier;
+}
+
+void SegmentedSearchServer::StartMerge() {
+	if (pending_merge_) {
+		return;
+	}
+
+	// ищем самую старую серию соседних сегментов одного яруса;
+	// сливаются только соседние сегменты, чтобы сохранить порядок добавления
+	const auto get_tier = [this](size_t segment_index) {
+		return GetTier(segments_[segment_index].index->GetDocumentCount(), flush_document_count_);
+	};
+	size_t first_segment = 0;
+	for (size_t i = 0; i < segments_.size(); ++i) {
+		if (i > 0 && get_tier(i) != get_tier(i - 1)) {
+			first_segment = i;
+		}
+		if (i - first_segment + 1 == SEGMENT_MERGE_FACTOR) {
+			break;
+		}
+	}
+	if (first_segment + SEGMENT_MERGE_FACTOR > segments_.size()) {
+		return;
+	}
+
+	vector<shared_ptr<const SearchServer>> inputs;
+	vector<unordered_set<int>> excluded_ids;
+	for (size_t i = first_segment; i < first_segment + SEGMENT_MERGE_FACTOR; ++i) {
+		inputs.push_back(segments_[i].index);
+		excluded_ids.push_back(segments_[i].removed_ids);
+	}
+	// задача пула читает только неизменяемые сегменты и собственные копии
+	auto result = ThreadPool::GetDefault().Submit([merged = empty_segment_, inputs, excluded_ids]() mutable {
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			merged.Merge(*inputs[i], excluded_ids[i]);
+		}
+		return shared_ptr<const SearchServer>(make_shared<SearchServer>(move(merged)));
+	});
+	pending_merge_ = PendingMerge{first_segment, SEGMENT_MERGE_FACTOR, move(excluded_ids), move(result)};
+}
+
+void SegmentedSearchServer::FinishMerge(bool wait) {
+	if (!pending_merge_) {
+		return;
+	}
+	if (!wait && pending_merge_->result.wait_for(chrono::seconds(0)) != future_status::ready) {
+		return;
+	}
+
+	PendingMerge pending_merge = move(*pending_merge_);
+	pending_merge_.reset();
+	const auto first = segments_.begin() + pending_merge.first_segment;
+	const auto last = first + pending_merge.segment_count;
+
+	// документы, удалённые во время слияния, остаются в результате с пометкой
+	Segment merged{pending_merge.result.get(), {}, {}};
+	for (auto it = first; it != last; ++it) {
+		const auto& excluded_ids = pending_merge.excluded_ids[it - first];
+		for (const int document_id : it->removed_ids) {
+			if (excluded_ids.count(document_id) == 0) {
+				merged.removed_ids.insert(document_id);
+			}
+		}
+	}
+	for (const int document_id : merged.removed_ids) {
+		for (const auto& [word, _] : merged.index->GetWordFrequencies(document_id)) {
+			++merged.removed_document_freqs[string(word)];
+		}
+	}
+
+	*first = move(merged);
+	segments_.erase(first + 1, last);
+	StartMerge();
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <execution>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "search_server.h"
+#include "thread_pool.h"
+
+// Сколько документов набирает изменяемый сегмент перед заморозкой
+const size_t SEGMENT_FLUSH_DOCUMENT_COUNT = 16384;
+// Столько замороженных сегментов одного яруса сливаются в один
+const size_t SEGMENT_MERGE_FACTOR = 4;
+
+// Индекс из сегментов, как в LSM-дереве. Новые документы попадают в небольшой
+// изменяемый сегмент; заполнившись, он сжимается и замораживается. Замороженные
+// сегменты не меняются: удаление документа из них лишь добавляет его id в список
+// удалённых сегмента. Когда набирается SEGMENT_MERGE_FACTOR соседних сегментов
+// одного яруса (ярус растёт в SEGMENT_MERGE_FACTOR раз), они сливаются задачей
+// общего пула потоков без повторного разбора текстов, а удалённые документы при этом отбрасываются.
+// Запрос выполняется в каждом сегменте с IDF по общей статистике, выдачи
+// сегментов объединяются. Как и SearchServer, класс не потокобезопасен.
+class SegmentedSearchServer {
+public:
+	explicit SegmentedSearchServer(const SearchServer& empty_segment,
+			size_t flush_document_count = SEGMENT_FLUSH_DOCUMENT_COUNT);
+	~SegmentedSearchServer();
+
+	SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+	SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+	void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+	void RemoveDocument(int document_id);
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query,
+			DocumentStatus status, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query) const;
+
+	int GetDocumentCount() const;
+	// Число замороженных сегментов
+	size_t GetSegmentCount() const;
+
+	// Замораживает изменяемый сегмент, не дожидаясь его заполнения
+	void Flush();
+	// Дожидается фоновых слияний и применяет их результаты
+	void WaitForMerge();
+
+private:
+	struct Segment {
+		std::shared_ptr<const SearchServer> index;
+		std::unordered_set<int> removed_ids;
+		// число удалённых документов с каждым словом, чтобы IDF считался по живым
+		std::map<std::string, int, std::less<>> removed_document_freqs;
+	};
+
+	struct PendingMerge {
+		size_t first_segment;
+		size_t segment_count;
+		// удалённые до начала слияния документы в результат не попадут
+		std::vector<std::unordered_set<int>> excluded_ids;
+		std::future<std::shared_ptr<const SearchServer>> result;
+	};
+
+	const SearchServer empty_segment_;
+	const size_t flush_document_count_;
+	SearchServer mutable_segment_;
+	std::vector<Segment> segments_;
+	std::optional<PendingMerge> pending_merge_;
+	int document_count_ = 0;
+
+	static size_t GetTier(size_t document_count, size_t flush_document_count);
+	void StartMerge();
+	void FinishMerge(bool wait);
+
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocumentsInSegments(const ExecutionPolicy& policy, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count) const;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate, size_t max_document_count) const {
+	return FindTopDocumentsInSegments(std::execution::seq, raw_query, document_predicate, max_document_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const std::execution::parallel_policy&,
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
+	return FindTopDocumentsInSegments(std::execution::par, raw_query, document_predicate, max_document_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocumentsInSegments(const ExecutionPolicy& policy,
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
+	// IDF считается по живым документам всех сегментов
+	CollectionStatistics statistics = mutable_segment_.GetCollectionStatistics(raw_query);
+	for (const Segment& segment : segments_) {
+		statistics += segment.index->GetCollectionStatistics(raw_query);
+		statistics.document_count -= segment.removed_ids.size();
+		for (auto& [word, document_freq] : statistics.document_freqs) {
+			const auto it = segment.removed_document_freqs.find(word);
+			if (it != segment.removed_document_freqs.end()) {
+				document_freq -= it->second;
+			}
+		}
+	}
+
+	// изменяемый сегмент последний: его документы добавлены позже остальных
+	std::vector<std::vector<Document>> segment_documents(segments_.size() + 1);
+	const auto find_in_segment = [&](size_t segment_index) {
+		if (segment_index == segments_.size()) {
+			segment_documents[segment_index] = mutable_segment_.FindTopDocuments(policy, raw_query,
+					document_predicate, max_document_count, statistics);
+			return;
+		}
+		const Segment& segment = segments_[segment_index];
+		const auto is_live = [&segment, &document_predicate](int document_id, DocumentStatus status, int rating) {
+			return segment.removed_ids.count(document_id) == 0 && document_predicate(document_id, status, rating);
+		};
+		segment_documents[segment_index] = segment.index->FindTopDocuments(policy, raw_query,
+				is_live, max_document_count, statistics);
+	};
+	if constexpr (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
+		ThreadPool::GetDefault().ParallelFor(segment_documents.size(), find_in_segment);
+	} else {
+		for (size_t segment_index = 0; segment_index < segment_documents.size(); ++segment_index) {
+			find_in_segment(segment_index);
+		}
+	}
+
+	TopDocumentsCollector collector(max_document_count);
+	for (const auto& documents : segment_documents) {
+		for (const Document& document : documents) {
+			collector.Add(document);
+		}
+	}
+	return std::move(collector).Extract();
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "sharded_search_server.h"
+
+using namespace std;
+
+ShardedSearchServer::ShardedSearchServer(const SearchServer& empty_shard, size_t shard_count)
+: shards_(max<size_t>(shard_count, 1), empty_shard)
+{
+	if (empty_shard.GetDocumentCount() > 0) {
+		throw invalid_argument("Shard prototype must be empty"s);
+	}
+}
+
+void ShardedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+		const vector<int>& ratings) {
+	shards_[GetShardIndex(document_id)].AddDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::AddDocuments(vector<NewDocument>&& documents) {
+	// проверяем весь пакет заранее, чтобы ошибка не оставила часть документов добавленной
+	unordered_set<int> batch_ids;
+	for (const auto& document : documents) {
+		if (document.id < 0 || shards_[GetShardIndex(document.id)].HasDocument(document.id)
+				|| !batch_ids.insert(document.id).second) {
+			throw invalid_argument("Invalid document_id"s);
+		}
+	}
+
+	vector<vector<NewDocument>> shard_documents(shards_.size());
+	for (auto& document : documents) {
+		shard_documents[GetShardIndex(document.id)].push_back(move(document));
+	}
+	ThreadPool::GetDefault().ParallelFor(shards_.size(), [this, &shard_documents](size_t shard_index) {
+		shards_[shard_index].AddDocuments(move(shard_documents[shard_index]));
+	});
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+	shards_[GetShardIndex(document_id)].RemoveDocument(document_id);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status,
+		size_t max_document_count) const {
+	return FindTopDocuments(raw_query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, max_document_count);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query) const {
+	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const execution::parallel_policy&, string_view raw_query,
+		DocumentStatus status, size_t max_document_count) const {
+	return FindTopDocuments(execution::par, raw_query, [status]([[maybe_unused]] int document_id,
+			DocumentStatus document_status, [[maybe_unused]] int rating) {
+		return document_status == status;
+	}, max_document_count);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const execution::parallel_policy&,
+		string_view raw_query) const {
+	return FindTopDocuments(execution::par, raw_query, DocumentStatus::ACTUAL);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+	int document_count = 0;
+	for (const SearchServer& shard : shards_) {
+		document_count += shard.GetDocumentCount();
+	}
+	return document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+	return shards_.size();
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+	// перемешиваем биты, чтобы id с общим шагом не попадали в одну часть
+	uint32_t hash = static_cast<uint32_t>(document_id);
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3bu;
+	hash ^= hash >> 16;
+	return hash % shards_.size();
+}
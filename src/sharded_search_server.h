@@ -0,0 +1,85 @@
+#pragma once
+
+#include <execution>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "thread_pool.h"
+
+// Поисковый сервер, разбитый на независимые части по хешу id документа.
+// Запрос сначала собирает со всех частей число документов с каждым словом,
+// чтобы IDF был тем же, что у единого индекса, затем выполняется во всех частях
+// параллельно, и лучшие документы частей объединяются.
+class ShardedSearchServer {
+public:
+	// empty_shard задаёт стоп-слова частей
+	ShardedSearchServer(const SearchServer& empty_shard, size_t shard_count);
+
+	void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+	// Документы пакета раскладываются по частям, части заполняются параллельно
+	void AddDocuments(std::vector<NewDocument>&& documents);
+	void RemoveDocument(int document_id);
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+			size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+	// Каждая часть тоже выполняет запрос параллельно
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query,
+			DocumentStatus status, size_t max_document_count = MAX_RESULT_DOCUMENT_COUNT) const;
+	std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query) const;
+
+	int GetDocumentCount() const;
+	size_t GetShardCount() const;
+
+private:
+	std::vector<SearchServer> shards_;
+
+	size_t GetShardIndex(int document_id) const;
+
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocumentsInShards(const ExecutionPolicy& policy, std::string_view raw_query,
+			DocumentPredicate document_predicate, size_t max_document_count) const;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate, size_t max_document_count) const {
+	return FindTopDocumentsInShards(std::execution::seq, raw_query, document_predicate, max_document_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::execution::parallel_policy&,
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
+	return FindTopDocumentsInShards(std::execution::par, raw_query, document_predicate, max_document_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocumentsInShards(const ExecutionPolicy& policy,
+		std::string_view raw_query, DocumentPredicate document_predicate, size_t max_document_count) const {
+	CollectionStatistics statistics;
+	for (const SearchServer& shard : shards_) {
+		statistics += shard.GetCollectionStatistics(raw_query);
+	}
+
+	std::vector<std::vector<Document>> shard_documents(shards_.size());
+	ThreadPool::GetDefault().ParallelFor(shards_.size(), [&](size_t shard_index) {
+		shard_documents[shard_index] = shards_[shard_index].FindTopDocuments(policy, raw_query,
+				document_predicate, max_document_count, statistics);
+	});
+
+	TopDocumentsCollector collector(max_document_count);
+	for (const auto& documents : shard_documents) {
+		for (const Document& document : documents) {
+			collector.Add(document);
+		}
+	}
+	return std::move(collector).Extract();
+}
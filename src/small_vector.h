@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Вектор, первые N элементов которого хранятся в самом объекте: пока элементов
+// не больше N, он не обращается к куче. Подходит только для тривиально
+// копируемых типов - элементы переносятся простым копированием.
+template <typename T, size_t N>
+class SmallVector {
+	static_assert(std::is_trivially_copyable_v<T>, "SmallVector requires trivially copyable elements");
+	static_assert(N > 0);
+
+public:
+	using value_type = T;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	SmallVector() = default;
+
+	SmallVector(const SmallVector& other) {
+		CopyFrom(other);
+	}
+
+	SmallVector& operator=(const SmallVector& other) {
+		if (this != &other) {
+			size_ = 0;
+			CopyFrom(other);
+		}
+		return *this;
+	}
+
+	SmallVector(SmallVector&& other) noexcept {
+		MoveFrom(other);
+	}
+
+	SmallVector& operator=(SmallVector&& other) noexcept {
+		if (this != &other) {
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	T* data() {
+		return heap_ ? heap_.get() : inline_;
+	}
+
+	const T* data() const {
+		return heap_ ? heap_.get() : inline_;
+	}
+
+	iterator begin() {
+		return data();
+	}
+
+	iterator end() {
+		return data() + size_;
+	}
+
+	const_iterator begin() const {
+		return data();
+	}
+
+	const_iterator end() const {
+		return data() + size_;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	size_t capacity() const {
+		return heap_ ? capacity_ : N;
+	}
+
+	T& operator[](size_t index) {
+		return data()[index];
+	}
+
+	const T& operator[](size_t index) const {
+		return data()[index];
+	}
+
+	void push_back(const T& value) {
+		if (size_ == capacity()) {
+			Reallocate(size_ * 2);
+		}
+		data()[size_++] = value;
+	}
+
+	void reserve(size_t capacity) {
+		if (capacity > this->capacity()) {
+			Reallocate(capacity);
+		}
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		T* const position = begin() + (first - begin());
+		T* const new_end = std::copy(begin() + (last - begin()), end(), position);
+		size_ = new_end - begin();
+		return position;
+	}
+
+	void clear() {
+		size_ = 0;
+	}
+
+private:
+	T inline_[N];
+	std::unique_ptr<T[]> heap_;
+	size_t capacity_ = 0;
+	size_t size_ = 0;
+
+	void Reallocate(size_t capacity) {
+		std::unique_ptr<T[]> heap(new T[capacity]);
+		std::copy(begin(), end(), heap.get());
+		heap_ = std::move(heap);
+		capacity_ = capacity;
+	}
+
+	void CopyFrom(const SmallVector& other) {
+		reserve(other.size_);
+		std::copy(other.begin(), other.end(), data());
+		size_ = other.size_;
+	}
+
+	void MoveFrom(SmallVector& other) {
+		if (other.heap_) {
+			heap_ = std::move(other.heap_);
+			capacity_ = other.capacity_;
+		} else {
+			heap_.reset();
+			std::copy(other.begin(), other.end(), inline_);
+		}
+		size_ = other.size_;
+		other.size_ = 0;
+	}
+};
@@ -1,28 +1,41 @@
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "string_processing.h"
+#include "tokenizer.h"
 
 using namespace std;
 
 vector<string_view> SplitIntoWordsView(string_view str) {
 	vector<string_view> result;
+	TokenizeWords(str, result);
+	return result;
+}
 
-	const int64_t pos_end = str.npos;
-
-	while (true) {
-		int64_t space = str.find(' ');
+bool IsValidWord(string_view word) {
+	// A valid word must not contain special characters
+	return none_of(word.begin(), word.end(), [](char c) {
+		return c >= '\0' && c < ' ';
+	});
+}
 
-		result.push_back(space == pos_end ? str.substr(0) : str.substr(0, space));
+QueryWord ParseQueryWord(string_view text) {
+	if (text.empty()) {
+		throw invalid_argument("Query word is empty"s);
+	}
 
-		if (space == pos_end) {
-			break;
-		} else {
-			str.remove_prefix(space + 1);
-		}
+	bool is_minus = false;
+	if (text[0] == '-') {
+		is_minus = true;
+		text.remove_prefix(1);
+	}
+	if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
+		throw invalid_argument("Query word "s + string(text) + " is invalid");
 	}
 
-	return result;
+	return {text, is_minus};
 }
-
@@ -9,6 +9,30 @@
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str);
 
+// Слово допустимо, если в нём нет управляющих символов
+bool IsValidWord(std::string_view word);
+
+struct QueryWord {
+	std::string_view data;
+	bool is_minus;
+};
+// Отделяет минус от слова запроса; для пустых и недопустимых слов выбрасывает invalid_argument
+QueryWord ParseQueryWord(std::string_view text);
+
+// То же без выделения памяти: func вызывается для каждого слова по порядку
+template <typename Func>
+void ForEachWordView(std::string_view str, Func func) {
+	while (true) {
+		const size_t space = str.find(' ');
+		if (space == str.npos) {
+			func(str);
+			return;
+		}
+		func(str.substr(0, space));
+		str.remove_prefix(space + 1);
+	}
+}
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& container) {
 	std::set<std::string, std::less<>> non_empty_words;
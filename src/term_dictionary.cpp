@@ -0,0 +1,47 @@
+#include <string>
+#include <string_view>
+
+#include "term_dictionary.h"
+
+using namespace std;
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+: terms_(other.terms_)
+{
+	// ключи должны ссылаться на собственные строки, а не на строки other
+	term_to_id_.reserve(terms_.size());
+	for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+		term_to_id_.emplace(terms_[term_id], term_id);
+	}
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+	if (this != &other) {
+		TermDictionary copy(other);
+		*this = move(copy);
+	}
+	return *this;
+}
+
+TermId TermDictionary::Intern(string_view word) {
+	if (const auto it = term_to_id_.find(word); it != term_to_id_.end()) {
+		return it->second;
+	}
+	const TermId term_id = static_cast<TermId>(terms_.size());
+	const string& term = terms_.emplace_back(word);
+	term_to_id_.emplace(term, term_id);
+	return term_id;
+}
+
+TermId TermDictionary::Find(string_view word) const {
+	const auto it = term_to_id_.find(word);
+	return it == term_to_id_.end() ? NO_TERM : it->second;
+}
+
+string_view TermDictionary::GetTerm(TermId term_id) const {
+	return terms_.at(term_id);
+}
+
+size_t TermDictionary::size() const {
+	return terms_.size();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using TermId = uint32_t;
+
+// Словарь терминов: каждому уникальному слову индекса сопоставляется плотный
+// целочисленный идентификатор. Строки хранятся в deque, поэтому string_view,
+// выданные словарём, остаются валидными до его разрушения.
+class TermDictionary {
+public:
+	static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+	TermDictionary() = default;
+	TermDictionary(const TermDictionary& other);
+	TermDictionary& operator=(const TermDictionary& other);
+	TermDictionary(TermDictionary&& other) = default;
+	TermDictionary& operator=(TermDictionary&& other) = default;
+
+	// Возвращает id слова, добавляя его в словарь при необходимости
+	TermId Intern(std::string_view word);
+
+	// Возвращает NO_TERM, если слова в словаре нет
+	TermId Find(std::string_view word) const;
+
+	std::string_view GetTerm(TermId term_id) const;
+
+	size_t size() const;
+
+private:
+	std::deque<std::string> terms_;
+	std::unordered_map<std::string_view, TermId> term_to_id_;
+};
@@ -651,6 +651,223 @@ void TestRemoveDocumentWithExecutionPolicy() {
 	ASSERT_EQUAL(search_server.FindTopDocuments(query).size(), 1u);
 }
 
+void TestAddDocuments() {
+	const auto make_text = [](int id) {
+		return "pet"s + to_string(id % 7) + " and rat"s + to_string(id % 5) + " pet"s + to_string(id % 3) + " curly"s;
+	};
+	SearchServer batch_server("and with"s);
+	SearchServer single_server("and with"s);
+	batch_server.AddDocument(100000, "curly pet1 dog"s, DocumentStatus::BANNED, {5});
+	single_server.AddDocument(100000, "curly pet1 dog"s, DocumentStatus::BANNED, {5});
+
+	vector<NewDocument> documents;
+	for (int id = 0; id < 3000; ++id) {
+		const DocumentStatus status = id % 4 == 0 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+		documents.push_back({id * 3, make_text(id), status, {id % 10, 1}});
+		single_server.AddDocument(id * 3, make_text(id), status, {id % 10, 1});
+	}
+	batch_server.AddDocuments(move(documents));
+
+	ASSERT_EQUAL(batch_server.GetDocumentCount(), single_server.GetDocumentCount());
+	ASSERT_EQUAL(vector<int>(batch_server.begin(), batch_server.end()),
+			vector<int>(single_server.begin(), single_server.end()));
+	ASSERT_EQUAL(batch_server.GetWordFrequencies(9), single_server.GetWordFrequencies(9));
+	for (const string& query : {"pet1"s, "rat2 -pet3"s, "curly dog"s, "pet6 rat4 pet2"s}) {
+		for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED}) {
+			const auto batch_docs = batch_server.FindTopDocuments(query, status, 5000);
+			const auto single_docs = single_server.FindTopDocuments(query, status, 5000);
+			ASSERT_EQUAL(batch_docs.size(), single_docs.size());
+			for (size_t i = 0; i < batch_docs.size(); ++i) {
+				ASSERT_EQUAL(batch_docs[i].id, single_docs[i].id);
+				ASSERT_EQUAL(batch_docs[i].rating, single_docs[i].rating);
+				ASSERT(abs(batch_docs[i].relevance - single_docs[i].relevance) < 1e-6);
+			}
+		}
+	}
+
+	// пакет с ошибкой не добавляется целиком
+	const auto assert_rejected = [&batch_server](vector<NewDocument> documents) {
+		try {
+			batch_server.AddDocuments(move(documents));
+			ASSERT_HINT(false, "AddDocuments must throw"s);
+		} catch (const invalid_argument&) {
+		}
+		ASSERT_EQUAL(batch_server.GetDocumentCount(), 3001);
+		ASSERT(batch_server.FindTopDocuments("parrot"s).empty());
+	};
+	assert_rejected({{200000, "parrot"s, DocumentStatus::ACTUAL, {}}, {-1, "parrot"s, DocumentStatus::ACTUAL, {}}});
+	assert_rejected({{200000, "parrot"s, DocumentStatus::ACTUAL, {}}, {3, "parrot"s, DocumentStatus::ACTUAL, {}}});
+	assert_rejected({{200000, "parrot"s, DocumentStatus::ACTUAL, {}}, {200000, "cat"s, DocumentStatus::ACTUAL, {}}});
+	assert_rejected({{200000, "parrot"s, DocumentStatus::ACTUAL, {}}, {200001, "par\x12rot"s, DocumentStatus::ACTUAL, {}}});
+}
+
+void TestRemoveDocuments() {
+	SearchServer batch_server("and with"s);
+	SearchServer single_server("and with"s);
+	for (int id = 0; id < 1000; ++id) {
+		const string text = "pet"s + to_string(id % 7) + " rat"s + to_string(id % 3) + " curly hair"s;
+		batch_server.AddDocument(id * 2, text, DocumentStatus::ACTUAL, {id});
+		single_server.AddDocument(id * 2, text, DocumentStatus::ACTUAL, {id});
+	}
+
+	// повторы и несуществующие id игнорируются
+	vector<int> removed_ids = {1, 3, 5000};
+	for (int id = 0; id < 2000; id += 6) {
+		removed_ids.push_back(id);
+		removed_ids.push_back(id);
+	}
+	batch_server.RemoveDocuments(removed_ids);
+	for (const int id : removed_ids) {
+		single_server.RemoveDocument(id);
+	}
+
+	ASSERT_EQUAL(batch_server.GetDocumentCount(), 666);
+	ASSERT_EQUAL(batch_server.GetDocumentCount(), single_server.GetDocumentCount());
+	vector<int> batch_ids(batch_server.begin(), batch_server.end());
+	vector<int> single_ids(single_server.begin(), single_server.end());
+	ASSERT_EQUAL(batch_ids, single_ids);
+	ASSERT_EQUAL(batch_ids.front(), 2);
+
+	for (const string& query : {"pet1"s, "rat2 -pet3"s, "curly"s}) {
+		const auto batch_docs = batch_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+		const auto single_docs = single_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+		ASSERT_EQUAL(batch_docs.size(), single_docs.size());
+		for (size_t i = 0; i < batch_docs.size(); ++i) {
+			ASSERT_EQUAL(batch_docs[i].id, single_docs[i].id);
+			ASSERT(abs(batch_docs[i].relevance - single_docs[i].relevance) < 1e-6);
+		}
+		// границы блоков после пакетного удаления остаются верхними границами
+		ASSERT_EQUAL(batch_server.FindTopDocuments(block_max_wand, query).size(),
+				batch_server.FindTopDocuments(query).size());
+	}
+}
+
+void TestRemoveDocumentsCompaction() {
+	const auto make_text = [](int id) {
+		return "pet"s + to_string(id % 7) + " rat"s + to_string(id % 5) + " hair"s + to_string(id % 11) + " curly"s;
+	};
+	const auto assert_same_results = [](const SearchServer& server, const SearchServer& expected_server) {
+		ASSERT_EQUAL(server.GetDocumentCount(), expected_server.GetDocumentCount());
+		for (const string& query : {"pet1"s, "rat2 -pet3 hair4"s, "curly"s, "pet5 rat1 hair10"s}) {
+			const auto docs = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 5000);
+			const auto expected_docs = expected_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 5000);
+			ASSERT_EQUAL(docs.size(), expected_docs.size());
+			for (size_t i = 0; i < docs.size(); ++i) {
+				ASSERT_EQUAL(docs[i].id, expected_docs[i].id);
+				ASSERT(abs(docs[i].relevance - expected_docs[i].relevance) < 1e-6);
+			}
+			const auto par_docs = server.FindTopDocuments(execution::par, query);
+			const auto wand_docs = server.FindTopDocuments(block_max_wand, query);
+			const auto top_docs = expected_server.FindTopDocuments(query);
+			ASSERT_EQUAL(par_docs.size(), top_docs.size());
+			ASSERT_EQUAL(wand_docs.size(), top_docs.size());
+			for (size_t i = 0; i < top_docs.size(); ++i) {
+				ASSERT_EQUAL(par_docs[i].id, top_docs[i].id);
+				ASSERT(abs(wand_docs[i].relevance - top_docs[i].relevance) < 1e-6);
+			}
+		}
+	};
+
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 4000; ++id) {
+		search_server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 10});
+	}
+
+	// удалённые документы пока остаются в списках вхождений, но в выдачу не попадают,
+	// а IDF считается только по оставшимся
+	vector<int> removed_ids;
+	for (int id = 0; id < 4000; id += 3) {
+		removed_ids.push_back(id);
+	}
+	// все документы со словом pet0
+	for (int id = 0; id < 4000; id += 7) {
+		removed_ids.push_back(id);
+	}
+	search_server.RemoveDocuments(removed_ids);
+
+	const auto build_expected = [&make_text](const SearchServer& server) {
+		SearchServer expected_server("and with"s);
+		for (const int id : server) {
+			expected_server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 10});
+		}
+		return expected_server;
+	};
+	assert_same_results(search_server, build_expected(search_server));
+	ASSERT(search_server.FindTopDocuments("pet0"s).empty());
+	ASSERT(search_server.GetWordFrequencies(3).empty());
+
+	// после удаления больше половины документов индекс сжимается сам
+	for (int id = 1; id < 4000; id += 3) {
+		search_server.RemoveDocument(id);
+	}
+	assert_same_results(search_server, build_expected(search_server));
+
+	// сжатие не меняет выдачу, новые документы получают номера после сжатых
+	search_server.RemoveDocument(2);
+	search_server.Compact();
+	search_server.AddDocument(10000, make_text(10000), DocumentStatus::ACTUAL, {0});
+	assert_same_results(search_server, build_expected(search_server));
+	const auto [words, status] = search_server.MatchDocument("curly pet4"s, 10000);
+	ASSERT_EQUAL(words.size(), 2u);
+}
+
+void TestDocumentColumnsAfterCompaction() {
+	const auto make_text = [](int id) {
+		return "pet"s + to_string(id % 7) + " rat"s + to_string(id % 5) + " curly"s;
+	};
+	const auto add_document = [&make_text](SearchServer& server, int id) {
+		server.AddDocument(id, make_text(id), static_cast<DocumentStatus>(id % 4), {id % 13, id % 6});
+	};
+
+	// статусы и рейтинги хранятся столбцами по внутреннему номеру и должны
+	// переезжать вместе с документом при сжатии и слиянии
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 3000; ++id) {
+		add_document(search_server, id);
+	}
+	vector<int> removed_ids;
+	for (int id = 0; id < 3000; ++id) {
+		if (id % 5 != 0) {
+			removed_ids.push_back(id);
+		}
+	}
+	search_server.RemoveDocuments(removed_ids);
+	SearchServer other("and with"s);
+	for (int id = 5000; id < 5100; ++id) {
+		add_document(other, id);
+	}
+	search_server.Merge(other);
+
+	SearchServer expected_server("and with"s);
+	for (const int id : search_server) {
+		add_document(expected_server, id);
+	}
+	const auto predicate = [](int document_id, DocumentStatus status, int rating) {
+		return status != DocumentStatus::BANNED && rating % 2 == 0 && document_id % 3 != 0;
+	};
+	for (const string& query : {"pet1"s, "rat2 -pet3"s, "curly"s}) {
+		const auto expected = expected_server.FindTopDocuments(query, predicate, 1000);
+		for (const auto& actual : {search_server.FindTopDocuments(query, predicate, 1000),
+				search_server.FindTopDocuments(execution::par, query, predicate, 1000),
+				search_server.FindTopDocuments(block_max_wand, query, predicate, 1000)}) {
+			ASSERT_EQUAL(actual.size(), expected.size());
+			for (size_t i = 0; i < expected.size(); ++i) {
+				ASSERT_EQUAL(actual[i].id, expected[i].id);
+				ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+				ASSERT(abs(actual[i].relevance - expected[i].relevance) < 1e-6);
+			}
+		}
+		for (const auto status : {DocumentStatus::IRRELEVANT, DocumentStatus::REMOVED}) {
+			const auto expected_batch = expected_server.FindTopDocumentsBatch(vector<string_view>{query}, status, 1000);
+			const auto actual_batch = search_server.FindTopDocumentsBatch(vector<string_view>{query}, status, 1000);
+			ASSERT_EQUAL(actual_batch[0].size(), expected_batch[0].size());
+		}
+	}
+	for (const int id : {0, 2995, 5003, 5099}) {
+		ASSERT(search_server.MatchDocument("pet1 curly"s, id) == expected_server.MatchDocument("pet1 curly"s, id));
+	}
+}
+
 void TestRemoveDuplicate() {
 	SearchServer search_server("and with"s);
 
@@ -815,6 +1032,1193 @@ void TestFindTopDocumentParrallel() {
 	}
 }
 
+void TestConcurrentSearchServer() {
+	const auto make_text = [](int id) {
+		return "cat"s + to_string(id % 10) + " dog"s + to_string(id % 7) + " and parrot"s;
+	};
+	ConcurrentSearchServer search_server(SearchServer("and with"s));
+	const vector<string> queries = {"cat1"s, "dog3 -cat2"s, "parrot"s, "cat4 dog4"s};
+
+	atomic_bool writers_done = false;
+	// первый писатель добавляет документы пачками, второй добавляет и удаляет по одному
+	thread batch_writer([&] {
+		for (int batch = 0; batch < 20; ++batch) {
+			vector<NewDocument> documents;
+			for (int id = batch * 100; id < (batch + 1) * 100; ++id) {
+				documents.push_back({id, make_text(id), DocumentStatus::ACTUAL, {id % 5}});
+			}
+			search_server.AddDocuments(move(documents));
+		}
+	});
+	thread single_writer([&] {
+		for (int i = 0; i < 1000; ++i) {
+			search_server.AddDocument(10000 + i, make_text(i), DocumentStatus::ACTUAL, {i % 5});
+			if (i % 2 == 1) {
+				search_server.RemoveDocument(10000 + i - 1);
+			}
+		}
+	});
+
+	// читатели не должны видеть индекс в промежуточном состоянии
+	vector<thread> readers;
+	atomic_int checked_snapshots = 0;
+	for (int reader = 0; reader < 2; ++reader) {
+		readers.emplace_back([&] {
+			do {
+				const auto snapshot = search_server.GetSnapshot();
+				const auto results = ProcessQueries(*snapshot, queries);
+				ASSERT_EQUAL(snapshot->GetDocumentCount(), distance(snapshot->begin(), snapshot->end()));
+				for (const auto& documents : results) {
+					for (const auto& document : documents) {
+						ASSERT(!snapshot->GetWordFrequencies(document.id).empty());
+					}
+				}
+				const auto repeated_results = ProcessQueries(*snapshot, queries);
+				ASSERT_EQUAL(results.size(), repeated_results.size());
+				for (size_t i = 0; i < results.size(); ++i) {
+					ASSERT_EQUAL(results[i].size(), repeated_results[i].size());
+					for (size_t j = 0; j < results[i].size(); ++j) {
+						ASSERT_EQUAL(results[i][j].id, repeated_results[i][j].id);
+					}
+				}
+				++checked_snapshots;
+			} while (!writers_done);
+		});
+	}
+
+	batch_writer.join();
+	single_writer.join();
+	writers_done = true;
+	for (auto& reader : readers) {
+		reader.join();
+	}
+	ASSERT(checked_snapshots > 0);
+
+	SearchServer expected_server("and with"s);
+	for (int id = 0; id < 2000; ++id) {
+		expected_server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 5});
+	}
+	for (int i = 1; i < 1000; i += 2) {
+		expected_server.AddDocument(10000 + i, make_text(i), DocumentStatus::ACTUAL, {i % 5});
+	}
+	ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+	const auto results = ProcessQueries(search_server, queries);
+	const auto expected_results = ProcessQueries(expected_server, queries);
+	for (size_t i = 0; i < results.size(); ++i) {
+		ASSERT_EQUAL(results[i].size(), expected_results[i].size());
+		for (size_t j = 0; j < results[i].size(); ++j) {
+			ASSERT(abs(results[i][j].relevance - expected_results[i][j].relevance) < 1e-6);
+		}
+	}
+
+	// ошибка не меняет ни одну из копий
+	try {
+		search_server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, {});
+		ASSERT_HINT(false, "AddDocument must throw"s);
+	} catch (const invalid_argument&) {
+	}
+	search_server.RemoveDocument(0);
+	ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount() - 1);
+	ASSERT_EQUAL(search_server.FindTopDocuments("cat0"s, DocumentStatus::ACTUAL, 1000).size(), 199u);
+	// перегрузка с параметрами поиска возвращает SearchResult и через обёртку
+	SearchOptions options;
+	options.max_document_count = 1000;
+	const SearchResult result = search_server.FindTopDocuments("cat0"s, options);
+	ASSERT(!result.is_truncated);
+	ASSERT_EQUAL(result.documents.size(), 199u);
+
+	// писатель спит, пока жив снимок предыдущей версии, и продолжает после его освобождения
+	auto held_snapshot = search_server.GetSnapshot();
+	atomic_bool is_written = false;
+	thread blocked_writer([&] {
+		search_server.RemoveDocument(1);
+		is_written = true;
+	});
+	this_thread::sleep_for(chrono::milliseconds(50));
+	ASSERT(!is_written);
+	ASSERT_EQUAL(held_snapshot->GetDocumentCount(), expected_server.GetDocumentCount() - 1);
+	ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount() - 2);
+	held_snapshot.reset();
+	blocked_writer.join();
+	ASSERT(is_written);
+}
+
+void TestSegmentedSearchServer() {
+	const auto make_text = [](int id) {
+		return "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " cat"s + to_string(id % 4) + " parrot"s;
+	};
+	SegmentedSearchServer search_server(SearchServer("and with"s), 50);
+	SearchServer expected_server("and with"s);
+	for (int id = 0; id < 3000; ++id) {
+		const DocumentStatus status = id % 9 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+		search_server.AddDocument(id, make_text(id), status, {id % 5});
+		expected_server.AddDocument(id, make_text(id), status, {id % 5});
+		// удаляем и из замороженных сегментов, и из изменяемого
+		if (id % 3 == 0) {
+			search_server.RemoveDocument(id / 2);
+			expected_server.RemoveDocument(id / 2);
+		}
+	}
+	try {
+		search_server.AddDocument(2000, "cat"s, DocumentStatus::ACTUAL, {});
+		ASSERT_HINT(false, "AddDocument must throw"s);
+	} catch (const invalid_argument&) {
+	}
+	// удалённый id можно добавить заново
+	search_server.AddDocument(0, "cat1 dog5"s, DocumentStatus::ACTUAL, {1});
+	expected_server.AddDocument(0, "cat1 dog5"s, DocumentStatus::ACTUAL, {1});
+
+	const auto assert_same_results = [&] {
+		ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+		for (const string& query : {"cat1"s, "dog3 -cat2"s, "parrot dog5"s, "cat4 dog4 -cat6"s}) {
+			for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+				const auto documents = search_server.FindTopDocuments(query, status, 5000);
+				const auto expected_documents = expected_server.FindTopDocuments(query, status, 5000);
+				ASSERT_EQUAL(documents.size(), expected_documents.size());
+				set<int> ids;
+				set<int> expected_ids;
+				for (size_t i = 0; i < documents.size(); ++i) {
+					ASSERT(abs(documents[i].relevance - expected_documents[i].relevance) < 1e-6);
+					ids.insert(documents[i].id);
+					expected_ids.insert(expected_documents[i].id);
+				}
+				ASSERT_EQUAL(ids, expected_ids);
+			}
+			const auto documents = search_server.FindTopDocuments(execution::par, query);
+			const auto expected_documents = expected_server.FindTopDocuments(query);
+			ASSERT_EQUAL(documents.size(), expected_documents.size());
+			for (size_t i = 0; i < documents.size(); ++i) {
+				ASSERT(abs(documents[i].relevance - expected_documents[i].relevance) < 1e-6);
+			}
+		}
+	};
+	assert_same_results();
+
+	// после слияний сегментов заметно меньше, чем заморозок
+	search_server.Flush();
+	search_server.WaitForMerge();
+	ASSERT(search_server.GetSegmentCount() < 3000 / 50 / 2);
+	assert_same_results();
+	for (int id = 100; id < 200; ++id) {
+		search_server.RemoveDocument(id);
+		expected_server.RemoveDocument(id);
+	}
+	assert_same_results();
+}
+
+void TestShardedSearchServer() {
+	const auto make_text = [](int id) {
+		return "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " cat"s + to_string(id % 4) + " parrot"s;
+	};
+	ShardedSearchServer search_server(SearchServer("and with"s), 4);
+	SearchServer expected_server("and with"s);
+	vector<NewDocument> documents;
+	for (int id = 0; id < 2000; ++id) {
+		const DocumentStatus status = id % 9 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+		if (id < 1000) {
+			search_server.AddDocument(id, make_text(id), status, {id % 5});
+		} else {
+			documents.push_back({id, make_text(id), status, {id % 5}});
+		}
+		expected_server.AddDocument(id, make_text(id), status, {id % 5});
+	}
+	search_server.AddDocuments(move(documents));
+	for (int id = 0; id < 2000; id += 3) {
+		search_server.RemoveDocument(id);
+		expected_server.RemoveDocument(id);
+	}
+	ASSERT_EQUAL(search_server.GetShardCount(), 4u);
+	ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+
+	// IDF считается по всем частям, поэтому релевантность как у единого индекса
+	const vector<string> queries = {"cat1"s, "dog3 -cat2"s, "parrot dog5"s, "cat4 dog4 -cat6"s};
+	for (const string& query : queries) {
+		for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+			const auto documents = search_server.FindTopDocuments(query, status, 5000);
+			const auto expected_documents = expected_server.FindTopDocuments(query, status, 5000);
+			ASSERT_EQUAL(documents.size(), expected_documents.size());
+			set<int> ids;
+			set<int> expected_ids;
+			for (size_t i = 0; i < documents.size(); ++i) {
+				ASSERT(abs(documents[i].relevance - expected_documents[i].relevance) < 1e-6);
+				ids.insert(documents[i].id);
+				expected_ids.insert(expected_documents[i].id);
+			}
+			ASSERT_EQUAL(ids, expected_ids);
+		}
+	}
+
+	const auto results = ProcessQueries(search_server, queries);
+	const auto expected_results = ProcessQueries(expected_server, queries);
+	ASSERT_EQUAL(results.size(), expected_results.size());
+	for (size_t i = 0; i < results.size(); ++i) {
+		ASSERT_EQUAL(results[i].size(), expected_results[i].size());
+		for (size_t j = 0; j < results[i].size(); ++j) {
+			ASSERT(abs(results[i][j].relevance - expected_results[i][j].relevance) < 1e-6);
+		}
+	}
+	ASSERT_EQUAL(ProcessQueriesJoined(search_server, queries).size(), 20u);
+
+	RequestQueue request_queue(search_server);
+	RequestQueue expected_request_queue(expected_server);
+	for (const string& query : {"cat1"s, "hamster"s, "dog2"s, "rat"s}) {
+		ASSERT_EQUAL(request_queue.AddFindRequest(query).size(), expected_request_queue.AddFindRequest(query).size());
+	}
+	ASSERT_EQUAL(request_queue.GetNoResultRequests(), 2);
+
+	try {
+		search_server.AddDocuments({{1, "cat"s, DocumentStatus::ACTUAL, {}}, {5000, "cat"s, DocumentStatus::ACTUAL, {}}});
+		ASSERT_HINT(false, "AddDocuments must throw"s);
+	} catch (const invalid_argument&) {
+	}
+	ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+}
+
+void TestThreadPool() {
+	ThreadPool pool(3);
+	ASSERT_EQUAL(pool.GetWorkerCount(), 3u);
+
+	vector<int> calls(10000);
+	pool.ParallelFor(calls.size(), [&calls](size_t index) {
+		++calls[index];
+	});
+	ASSERT(all_of(calls.begin(), calls.end(), [](int count) { return count == 1; }));
+
+	// вложенные вызовы не блокируют друг друга: ожидающий поток выполняет чужие задачи
+	atomic_int nested_calls = 0;
+	pool.ParallelFor(20, [&pool, &nested_calls](size_t) {
+		pool.ParallelFor(50, [&nested_calls](size_t) {
+			++nested_calls;
+		});
+	});
+	ASSERT_EQUAL(nested_calls.load(), 1000);
+
+	try {
+		pool.ParallelFor(100, [](size_t index) {
+			if (index == 42) {
+				throw out_of_range("42"s);
+			}
+		});
+		ASSERT_HINT(false, "ParallelFor must rethrow"s);
+	} catch (const out_of_range& e) {
+		ASSERT_EQUAL(string(e.what()), "42"s);
+	}
+	pool.ParallelFor(0, [](size_t) {
+		ASSERT_HINT(false, "No calls expected"s);
+	});
+
+	auto future = pool.Submit([] { return 6 * 7; });
+	ASSERT_EQUAL(future.get(), 42);
+}
+
+void TestFindTopDocumentsWithDeadline() {
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 5000; ++id) {
+		const string text = "cat"s + to_string(id % 10) + " dog"s + to_string(id % 7) + " parrot"s;
+		search_server.AddDocument(id, text, id % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 5});
+	}
+
+	// без срока результат тот же, что у обычного поиска
+	const string query = "cat1 dog2 parrot -cat3"s;
+	SearchOptions options;
+	options.status = DocumentStatus::BANNED;
+	options.max_document_count = 20;
+	const auto expected_documents = search_server.FindTopDocuments(query, DocumentStatus::BANNED, 20);
+	const auto assert_complete = [&expected_documents](const SearchResult& result) {
+		ASSERT(!result.is_truncated);
+		ASSERT_EQUAL(result.documents.size(), expected_documents.size());
+		for (size_t i = 0; i < expected_documents.size(); ++i) {
+			ASSERT_EQUAL(result.documents[i].id, expected_documents[i].id);
+		}
+	};
+	assert_complete(search_server.FindTopDocuments(query, options));
+	options.deadline = chrono::steady_clock::now() + chrono::hours(1);
+	assert_complete(search_server.FindTopDocuments(query, options));
+	assert_complete(search_server.FindTopDocumentsAsync(query, options).get());
+
+	// истёкший срок прерывает поиск до оценки документов, но минус-слова учтены
+	options.deadline = chrono::steady_clock::now() - chrono::milliseconds(1);
+	const SearchResult truncated = search_server.FindTopDocumentsAsync(query, options).get();
+	ASSERT(truncated.is_truncated);
+	ASSERT(truncated.documents.empty());
+
+	try {
+		search_server.FindTopDocumentsAsync("cat --dog"s).get();
+		ASSERT_HINT(false, "Invalid query must throw"s);
+	} catch (const invalid_argument&) {
+	}
+}
+
+void TestFindTopDocumentsBatch() {
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 3000; ++id) {
+		const string text = "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " cat"s + to_string(id % 3);
+		search_server.AddDocument(id, text, id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 4});
+	}
+	for (int id = 0; id < 3000; id += 11) {
+		search_server.RemoveDocument(id);
+	}
+
+	// повторы, запросы с общими словами, минус-слова и слова, которых нет в индексе
+	vector<string> queries;
+	for (int i = 0; i < 200; ++i) {
+		queries.push_back("cat"s + to_string(i % 10) + " dog"s + to_string(i % 13) + " -cat"s + to_string(i % 4)
+				+ (i % 6 == 0 ? " and parrot"s : ""s));
+	}
+	queries.push_back("parrot"s);
+	queries.push_back("cat1"s);
+	queries.push_back("cat1"s);
+
+	vector<string_view> raw_queries(queries.begin(), queries.end());
+	for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+		const auto results = search_server.FindTopDocumentsBatch(raw_queries, status, 7);
+		ASSERT_EQUAL(results.size(), queries.size());
+		for (size_t i = 0; i < queries.size(); ++i) {
+			const auto expected = search_server.FindTopDocuments(queries[i], status, 7);
+			ASSERT_EQUAL(results[i].size(), expected.size());
+			for (size_t j = 0; j < expected.size(); ++j) {
+				ASSERT_EQUAL(results[i][j].id, expected[j].id);
+				ASSERT_EQUAL(results[i][j].rating, expected[j].rating);
+				ASSERT(abs(results[i][j].relevance - expected[j].relevance) < 1e-9);
+			}
+		}
+	}
+	ASSERT(search_server.FindTopDocumentsBatch(vector<string_view>{}).empty());
+}
+
+void TestResultCache() {
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 500; ++id) {
+		search_server.AddDocument(id, "cat"s + to_string(id % 10) + " dog"s + to_string(id % 7),
+				id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 4});
+	}
+	const auto check_equal = [](const vector<Document>& actual, const vector<Document>& expected) {
+		ASSERT_EQUAL(actual.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			ASSERT_EQUAL(actual[i].id, expected[i].id);
+			ASSERT(abs(actual[i].relevance - expected[i].relevance) < 1e-9);
+		}
+	};
+
+	// без кэша счётчики не меняются
+	const auto uncached = search_server.FindTopDocuments("cat1 dog2"s);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().misses, 0u);
+
+	search_server.SetResultCacheCapacity(4);
+	check_equal(search_server.FindTopDocuments("cat1 dog2"s), uncached);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().misses, 1u);
+	// порядок и повтор слов не влияют на ключ
+	check_equal(search_server.FindTopDocuments(execution::par, "dog2 cat1 cat1"s), uncached);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().hits, 1u);
+	// статус и число документов входят в ключ
+	search_server.FindTopDocuments("cat1 dog2"s, DocumentStatus::BANNED);
+	search_server.FindTopDocuments("cat1 dog2"s, DocumentStatus::ACTUAL, 2);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().misses, 3u);
+
+	// изменение индекса делает записи устаревшими
+	search_server.AddDocument(1000, "cat1 dog2 cat1"s, DocumentStatus::ACTUAL, {9});
+	const auto added = search_server.FindTopDocuments("cat1 dog2"s);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().misses, 4u);
+	ASSERT_EQUAL(added.front().id, 1000);
+	search_server.RemoveDocument(1000);
+	check_equal(search_server.FindTopDocuments("cat1 dog2"s), uncached);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().misses, 5u);
+
+	// копия индекса начинает с пустого кэша той же ёмкости
+	const SearchServer copy = search_server;
+	copy.FindTopDocuments("cat1 dog2"s);
+	ASSERT_EQUAL(copy.GetResultCacheStats().hits, 0u);
+	ASSERT_EQUAL(copy.GetResultCacheStats().misses, 1u);
+
+	// параллельные запросы к общему кэшу, который меньше числа разных запросов
+	vector<string> queries;
+	for (int i = 0; i < 300; ++i) {
+		queries.push_back("cat"s + to_string(i % 10) + " -dog"s + to_string(i % 7));
+	}
+	const auto results = ProcessQueries(search_server, queries);
+	for (size_t i = 0; i < queries.size(); ++i) {
+		search_server.SetResultCacheCapacity(0);
+		const auto expected = search_server.FindTopDocuments(queries[i]);
+		search_server.SetResultCacheCapacity(4);
+		check_equal(results[i], expected);
+	}
+	const auto batch_results = ProcessQueries(search_server, queries);
+	ASSERT_EQUAL(search_server.GetResultCacheStats().hits + search_server.GetResultCacheStats().misses, 70u);
+	for (size_t i = 0; i < queries.size(); ++i) {
+		check_equal(batch_results[i], results[i]);
+	}
+
+	// ёмкость соблюдается для всего кэша, а не для каждой части
+	for (size_t capacity : {1u, 5u, 16u, 21u}) {
+		const ResultCache cache(capacity);
+		for (int i = 0; i < 100; ++i) {
+			cache.Insert("query"s + to_string(i), 1, {});
+		}
+		ASSERT_EQUAL(cache.GetSize(), capacity);
+	}
+}
+
+void TestPreparedQuery() {
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 400; ++id) {
+		search_server.AddDocument(id, "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " cat"s + to_string(id % 3),
+				id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 4});
+	}
+	const auto check_equal = [](const vector<Document>& actual, const vector<Document>& expected) {
+		ASSERT_EQUAL(actual.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			ASSERT_EQUAL(actual[i].id, expected[i].id);
+			ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+			ASSERT(abs(actual[i].relevance - expected[i].relevance) < 1e-9);
+		}
+	};
+
+	const string raw_query = "cat1 dog2 cat1 and parrot -cat2 -cat2"s;
+	const PreparedQuery query = search_server.PrepareQuery(raw_query);
+	const auto is_even = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+	check_equal(search_server.FindTopDocuments(query), search_server.FindTopDocuments(raw_query));
+	check_equal(search_server.FindTopDocuments(query, DocumentStatus::BANNED, 3),
+			search_server.FindTopDocuments(raw_query, DocumentStatus::BANNED, 3));
+	check_equal(search_server.FindTopDocuments(query, is_even), search_server.FindTopDocuments(raw_query, is_even));
+	check_equal(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, 10),
+			search_server.FindTopDocuments(execution::par, raw_query, DocumentStatus::ACTUAL, 10));
+	check_equal(search_server.FindTopDocuments(block_max_wand, query, is_even, 10),
+			search_server.FindTopDocuments(block_max_wand, raw_query, is_even, 10));
+	check_equal(search_server.FindTopDocuments(query, SearchOptions{}).documents, search_server.FindTopDocuments(raw_query));
+	check_equal(search_server.FindTopDocumentsAsync(query).get().documents, search_server.FindTopDocuments(raw_query));
+	check_equal(search_server.FindTopDocumentsBatch(vector<PreparedQuery>{query, query})[1],
+			search_server.FindTopDocuments(raw_query));
+
+	// пакетное сопоставление совпадает с сопоставлением по одному документу
+	const vector<int> document_ids = {7, 2, 399, 11, 2, 5};
+	const auto matches = search_server.MatchDocuments(query, document_ids);
+	ASSERT_EQUAL(matches.size(), document_ids.size());
+	for (size_t i = 0; i < document_ids.size(); ++i) {
+		const auto [expected_words, expected_status] = search_server.MatchDocument(raw_query, document_ids[i]);
+		const auto [words, status] = search_server.MatchDocument(execution::par, query, document_ids[i]);
+		ASSERT(words == expected_words);
+		ASSERT(status == expected_status);
+		ASSERT(get<0>(matches[i]) == expected_words);
+		ASSERT(get<1>(matches[i]) == expected_status);
+	}
+	ASSERT_EQUAL(get<0>(matches[0]).size(), 1u);
+	ASSERT(get<0>(matches[1]).empty());
+	try {
+		search_server.MatchDocuments(query, {1, 1000});
+		ASSERT_HINT(false, "MatchDocuments must throw for unknown document id"s);
+	} catch (const out_of_range&) {
+	}
+	try {
+		search_server.PrepareQuery("cat --dog"s);
+		ASSERT_HINT(false, "PrepareQuery must throw for invalid query"s);
+	} catch (const invalid_argument&) {
+	}
+
+	// после изменения индекса термины и IDF находятся заново
+	search_server.AddDocument(1000, "parrot cat1 dog2"s, DocumentStatus::ACTUAL, {10});
+	search_server.RemoveDocument(1);
+	check_equal(search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10),
+			search_server.FindTopDocuments(raw_query, DocumentStatus::ACTUAL, 10));
+	ASSERT_EQUAL(search_server.FindTopDocuments(query).front().id, 1000);
+
+	// запрос, подготовленный на другом сервере
+	SearchServer other_server("and with"s);
+	other_server.AddDocument(5, "dog2 parrot"s, DocumentStatus::ACTUAL, {1});
+	other_server.AddDocument(6, "cat2 parrot"s, DocumentStatus::ACTUAL, {1});
+	check_equal(other_server.FindTopDocuments(query), other_server.FindTopDocuments(raw_query));
+	ASSERT_EQUAL(other_server.FindTopDocuments(query).size(), 1u);
+}
+
+void TestParseQueryWithoutAllocations() {
+	SearchServer search_server("and with"s);
+	search_server.AddDocument(1, "white cat with fashionable collar"s, DocumentStatus::ACTUAL, {1});
+	search_server.AddDocument(2, "fluffy dog and expressive eyes"s, DocumentStatus::ACTUAL, {2});
+
+	// документ 1 содержит минус-слово, поэтому пустой результат тоже не выделяет память
+	const string query = "fluffy -cat and dog parrot with eyes dog"s;
+	string long_query = "-cat"s;
+	for (size_t i = 0; i <= QUERY_INLINE_TERM_COUNT; ++i) {
+		long_query += " word"s + to_string(i);
+	}
+	// ASSERT сам выделяет память, поэтому счётчик снимается до проверок
+	size_t allocations = 0;
+	size_t long_allocations = 0;
+	{
+		AllocationCounter counter;
+		const auto [words, status] = search_server.MatchDocument(query, 1);
+		allocations = counter.GetAllocationCount();
+		ASSERT(words.empty());
+	}
+	ASSERT_EQUAL(allocations, 0u);
+	{
+		// слова сверх встроенного буфера размещаются в куче
+		AllocationCounter counter;
+		const auto [long_words, long_status] = search_server.MatchDocument(long_query, 1);
+		long_allocations = counter.GetAllocationCount();
+		ASSERT(long_words.empty());
+	}
+	ASSERT(long_allocations > 0);
+
+	// разбор по-прежнему проверяет слова
+	try {
+		search_server.MatchDocument("fluffy --dog"s, 2);
+		ASSERT_HINT(false, "MatchDocument must throw for invalid query"s);
+	} catch (const invalid_argument&) {
+	}
+	try {
+		search_server.MatchDocument("fluffy  dog"s, 2);
+		ASSERT_HINT(false, "MatchDocument must throw for empty query word"s);
+	} catch (const invalid_argument&) {
+	}
+}
+
+void TestTokenizeWords() {
+	// байты 0x80-0xFF допустимы, 0x00-0x1F нет; длины пересекают границы векторов
+	const string alphabet = "ab  -\x01\x1f\x7f\x80\xff"s;
+	mt19937 generator(42);
+	vector<TokenizerLevel> levels = {TokenizerLevel::SCALAR};
+	if (GetSupportedTokenizerLevel() != TokenizerLevel::SCALAR) {
+		levels.push_back(TokenizerLevel::SSE2);
+	}
+	if (GetSupportedTokenizerLevel() == TokenizerLevel::AVX2) {
+		levels.push_back(TokenizerLevel::AVX2);
+	}
+
+	for (int i = 0; i < 2000; ++i) {
+		string text(uniform_int_distribution<size_t>(0, 100)(generator), 'a');
+		for (char& c : text) {
+			c = alphabet[uniform_int_distribution<size_t>(0, alphabet.size() - 1)(generator)];
+			// управляющие символы редки, чтобы встречались и допустимые тексты
+			if (static_cast<unsigned char>(c) < 0x20 && generator() % 8 != 0) {
+				c = 'c';
+			}
+		}
+		vector<string_view> expected_words;
+		ForEachWordView(text, [&expected_words](string_view word) {
+			expected_words.push_back(word);
+		});
+		const size_t expected_invalid = find_if(text.begin(), text.end(), [](char c) {
+			return c >= '\0' && c < ' ';
+		}) - text.begin();
+
+		for (const auto level : levels) {
+			vector<string_view> words = {"previous"sv};
+			const size_t invalid = TokenizeWords(text, words, level);
+			ASSERT_EQUAL(invalid, expected_invalid == text.size() ? string_view::npos : expected_invalid);
+			ASSERT_EQUAL(words.size(), expected_words.size() + 1);
+			ASSERT(equal(expected_words.begin(), expected_words.end(), words.begin() + 1));
+			ASSERT_EQUAL(words.front(), "previous"sv);
+		}
+	}
+
+	SearchServer search_server("in the"s);
+	try {
+		search_server.AddDocument(1, "cat in the ci\x12ty"s, DocumentStatus::ACTUAL, {1});
+		ASSERT_HINT(false, "AddDocument must throw for invalid word"s);
+	} catch (const invalid_argument& error) {
+		ASSERT_EQUAL(string(error.what()), "Word ci\x12ty is invalid"s);
+	}
+	ASSERT_EQUAL(search_server.GetDocumentCount(), 0);
+}
+
+void TestSnapshot() {
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 3000; ++id) {
+		search_server.AddDocument(id * 3, "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " cat"s + to_string(id % 3),
+				static_cast<DocumentStatus>(id % 3), {id % 4, id % 9});
+	}
+	// удалённые документы сохраняются как пропуски номеров
+	for (int id = 0; id < 3000; id += 7) {
+		search_server.RemoveDocument(id * 3);
+	}
+
+	const string path = (filesystem::temp_directory_path() / "search_server_test.snapshot"s).string();
+	search_server.SaveSnapshot(path);
+	SearchServer loaded = SearchServer::LoadSnapshot(path);
+
+	const auto check_same = [](const SearchServer& lhs, const SearchServer& rhs) {
+		ASSERT_EQUAL(lhs.GetDocumentCount(), rhs.GetDocumentCount());
+		ASSERT(equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()));
+		for (const string& query : {"cat1 dog2"s, "cat3 -dog4 cat0"s, "dog6 parrot"s, "and"s}) {
+			for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED}) {
+				const auto expected = lhs.FindTopDocuments(query, status, 20);
+				for (const auto& actual : {rhs.FindTopDocuments(query, status, 20),
+						rhs.FindTopDocuments(execution::par, query, status, 20),
+						rhs.FindTopDocuments(block_max_wand, query, status, 20)}) {
+					ASSERT_EQUAL(actual.size(), expected.size());
+					for (size_t i = 0; i < expected.size(); ++i) {
+						ASSERT_EQUAL(actual[i].id, expected[i].id);
+						ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+						ASSERT_EQUAL(actual[i].relevance, expected[i].relevance);
+					}
+				}
+			}
+		}
+		for (const int document_id : {6, 300, 8997}) {
+			ASSERT(lhs.GetWordFrequencies(document_id) == rhs.GetWordFrequencies(document_id));
+			ASSERT(lhs.MatchDocument("cat1 dog1 cat2"s, document_id) == rhs.MatchDocument("cat1 dog1 cat2"s, document_id));
+		}
+	};
+	check_same(search_server, loaded);
+	ASSERT(loaded.GetStopWords() == search_server.GetStopWords());
+
+	// загруженный индекс продолжает работать как исходный
+	for (SearchServer* server : {&search_server, &loaded}) {
+		server->AddDocument(100000, "cat1 with dog2"s, DocumentStatus::ACTUAL, {5});
+		server->RemoveDocument(3);
+	}
+	check_same(search_server, loaded);
+
+	SearchServer().SaveSnapshot(path);
+	ASSERT_EQUAL(SearchServer::LoadSnapshot(path).GetDocumentCount(), 0);
+
+	// повреждённый, обрезанный и отсутствующий файлы
+	search_server.SaveSnapshot(path);
+	string data;
+	{
+		ifstream input(path, ios::binary);
+		data.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+	}
+	const auto check_load_fails = [&path](const string& content) {
+		{
+			ofstream output(path, ios::binary | ios::trunc);
+			output << content;
+		}
+		try {
+			SearchServer::LoadSnapshot(path);
+			ASSERT_HINT(false, "LoadSnapshot must reject damaged file"s);
+		} catch (const runtime_error&) {
+		}
+	};
+	string damaged = data;
+	damaged[damaged.size() / 2] ^= 1;
+	check_load_fails(damaged);
+	check_load_fails(data.substr(0, data.size() - 1));
+	check_load_fails(data.substr(0, 10));
+	check_load_fails("not a snapshot"s);
+	filesystem::remove(path);
+	try {
+		SearchServer::LoadSnapshot(path);
+		ASSERT_HINT(false, "LoadSnapshot must throw for missing file"s);
+	} catch (const runtime_error&) {
+	}
+}
+
+void TestMappedSearchServer() {
+	SearchServer search_server("and with"s);
+	for (int id = 0; id < 3000; ++id) {
+		search_server.AddDocument(id * 3, "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " cat"s + to_string(id % 3),
+				static_cast<DocumentStatus>(id % 3), {id % 4, id % 9});
+	}
+	// удалённые документы в файл не попадают, номера живых сжимаются
+	for (int id = 0; id < 3000; id += 7) {
+		search_server.RemoveDocument(id * 3);
+	}
+
+	const string path = (filesystem::temp_directory_path() / "search_server_test.index"s).string();
+	search_server.SaveMappedIndex(path);
+	const MappedSearchServer mapped(path);
+
+	const auto check_same = [](const vector<Document>& actual, const vector<Document>& expected) {
+		ASSERT_EQUAL(actual.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			ASSERT_EQUAL(actual[i].id, expected[i].id);
+			ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+			ASSERT_EQUAL(actual[i].relevance, expected[i].relevance);
+		}
+	};
+	ASSERT_EQUAL(mapped.GetDocumentCount(), search_server.GetDocumentCount());
+	ASSERT(mapped.HasDocument(3) && !mapped.HasDocument(0) && !mapped.HasDocument(1) && !mapped.HasDocument(-1));
+	for (const string& query : {"cat1 dog2"s, "cat3 -dog4 cat0"s, "dog6 parrot"s, "and"s, "-cat1 dog1"s}) {
+		for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED}) {
+			check_same(mapped.FindTopDocuments(query, status, 20), search_server.FindTopDocuments(query, status, 20));
+		}
+	}
+	const auto is_even = [](int document_id, [[maybe_unused]] DocumentStatus status, [[maybe_unused]] int rating) {
+		return document_id % 2 == 0;
+	};
+	check_same(mapped.FindTopDocuments("cat2 dog3"s, is_even), search_server.FindTopDocuments("cat2 dog3"s, is_even));
+	for (const int document_id : {6, 300, 8997}) {
+		ASSERT(mapped.MatchDocument("cat1 dog1 -cat2"s, document_id)
+				== search_server.MatchDocument("cat1 dog1 -cat2"s, document_id));
+		ASSERT(mapped.MatchDocument("cat1 dog1 cat2"s, document_id)
+				== search_server.MatchDocument("cat1 dog1 cat2"s, document_id));
+	}
+	try {
+		mapped.MatchDocument("cat1"s, 0);
+		ASSERT_HINT(false, "MatchDocument must throw for removed document"s);
+	} catch (const out_of_range&) {
+	}
+	try {
+		mapped.FindTopDocuments("cat1 --dog2"s);
+		ASSERT_HINT(false, "FindTopDocuments must reject invalid query"s);
+	} catch (const invalid_argument&) {
+	}
+
+	// сервер можно перемещать: данные остаются в том же отображении
+	MappedSearchServer opened(path);
+	MappedSearchServer moved(move(opened));
+	check_same(moved.FindTopDocuments("cat1 dog2"s), search_server.FindTopDocuments("cat1 dog2"s));
+
+	SearchServer().SaveMappedIndex(path);
+	ASSERT_EQUAL(MappedSearchServer(path).GetDocumentCount(), 0);
+	ASSERT(MappedSearchServer(path).FindTopDocuments("cat"s).empty());
+
+	// заголовок с неверными границами и чужие файлы
+	search_server.SaveMappedIndex(path);
+	string data;
+	{
+		ifstream input(path, ios::binary);
+		data.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+	}
+	const auto check_open_fails = [&path](const string& content) {
+		{
+			ofstream output(path, ios::binary | ios::trunc);
+			output << content;
+		}
+		try {
+			MappedSearchServer server(path);
+			ASSERT_HINT(false, "MappedSearchServer must reject damaged file"s);
+		} catch (const runtime_error&) {
+		}
+	};
+	string damaged = data;
+	reinterpret_cast<MappedIndexHeader*>(damaged.data())->terms.size += sizeof(MappedIndexTerm);
+	check_open_fails(damaged);
+	check_open_fails(data.substr(0, data.size() - 1));
+	check_open_fails(data.substr(0, 10));
+	check_open_fails("not an index"s);
+	filesystem::remove(path);
+	try {
+		MappedSearchServer server(path);
+		ASSERT_HINT(false, "MappedSearchServer must throw for missing file"s);
+	} catch (const runtime_error&) {
+	}
+}
+
+void TestDurableSearchServer() {
+	const filesystem::path directory = filesystem::temp_directory_path() / "search_server_test_wal"s;
+	filesystem::remove_all(directory);
+
+	SearchServer expected("and with"s);
+	const auto check_recovered = [&directory, &expected] {
+		const DurableSearchServer recovered(directory.string());
+		ASSERT_EQUAL(recovered.GetDocumentCount(), expected.GetDocumentCount());
+		ASSERT(equal(recovered.GetSnapshot()->begin(), recovered.GetSnapshot()->end(), expected.begin(), expected.end()));
+		for (const string& query : {"cat1 dog2"s, "cat3 -dog4 cat0"s, "dog6 parrot"s}) {
+			const auto actual_documents = recovered.FindTopDocuments(query);
+			const auto expected_documents = expected.FindTopDocuments(query);
+			ASSERT_EQUAL(actual_documents.size(), expected_documents.size());
+			for (size_t i = 0; i < expected_documents.size(); ++i) {
+				ASSERT_EQUAL(actual_documents[i].id, expected_documents[i].id);
+				ASSERT_EQUAL(actual_documents[i].relevance, expected_documents[i].relevance);
+			}
+		}
+	};
+	const auto make_text = [](int id) {
+		return "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7);
+	};
+
+	{
+		DurableSearchServer server(directory.string(), "and with"sv);
+		for (int id = 0; id < 200; ++id) {
+			server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 5});
+			expected.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 5});
+		}
+		server.RemoveDocument(3);
+		expected.RemoveDocument(3);
+		// отклонённое изменение не применяется ни сразу, ни при восстановлении
+		try {
+			server.AddDocument(5, "cat1"s, DocumentStatus::ACTUAL, {1});
+			ASSERT_HINT(false, "AddDocument must reject duplicate id"s);
+		} catch (const invalid_argument&) {
+		}
+		vector<NewDocument> documents;
+		for (int id = 200; id < 300; ++id) {
+			documents.push_back({id, make_text(id), DocumentStatus::ACTUAL, {id % 3}});
+		}
+		expected.AddDocuments(vector<NewDocument>(documents));
+		server.AddDocuments(move(documents));
+	}
+	check_recovered();
+
+	// после контрольной точки журнал начинается заново, а стоп-слова берутся из снимка
+	{
+		DurableSearchServer server(directory.string());
+		server.Checkpoint();
+		server.RemoveDocuments({10, 11, 12});
+		expected.RemoveDocuments({10, 11, 12});
+		server.AddDocument(1000, "cat1 with dog2"s, DocumentStatus::ACTUAL, {7});
+		expected.AddDocument(1000, "cat1 with dog2"s, DocumentStatus::ACTUAL, {7});
+	}
+	check_recovered();
+	size_t snapshot_count = 0;
+	for (const auto& entry : filesystem::directory_iterator(directory)) {
+		snapshot_count += entry.path().extension() == ".bin"s;
+	}
+	ASSERT_EQUAL(snapshot_count, 1u);
+
+	// недописанная при сбое запись отбрасывается
+	filesystem::path last_segment;
+	for (const auto& entry : filesystem::directory_iterator(directory)) {
+		if (entry.path().extension() == ".log"s && entry.path() > last_segment) {
+			last_segment = entry.path();
+		}
+	}
+	{
+		DurableSearchServer server(directory.string());
+		server.AddDocument(1001, "cat2 dog2"s, DocumentStatus::ACTUAL, {1});
+		expected.AddDocument(1001, "cat2 dog2"s, DocumentStatus::ACTUAL, {1});
+	}
+	for (const auto& entry : filesystem::directory_iterator(directory)) {
+		if (entry.path().extension() == ".log"s && entry.path() > last_segment) {
+			last_segment = entry.path();
+		}
+	}
+	const auto segment_size = filesystem::file_size(last_segment);
+	{
+		ofstream output(last_segment, ios::binary | ios::app);
+		output << "torn record"s;
+	}
+	check_recovered();
+	ASSERT_EQUAL(filesystem::file_size(last_segment), segment_size);
+
+	// одновременные писатели
+	{
+		DurableSearchServer server(directory.string());
+		vector<thread> writers;
+		for (int thread_index = 0; thread_index < 4; ++thread_index) {
+			writers.emplace_back([&server, thread_index, &make_text] {
+				for (int id = 2000 + thread_index * 50; id < 2000 + (thread_index + 1) * 50; ++id) {
+					server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {1});
+				}
+			});
+		}
+		for (thread& writer : writers) {
+			writer.join();
+		}
+		ASSERT_EQUAL(server.GetDocumentCount(), expected.GetDocumentCount() + 200);
+	}
+	const DurableSearchServer recovered(directory.string());
+	ASSERT_EQUAL(recovered.GetDocumentCount(), expected.GetDocumentCount() + 200);
+	ASSERT_EQUAL(get<0>(recovered.GetSnapshot()->MatchDocument("cat3 dog2"s, 2123)).size(), 2u);
+	filesystem::remove_all(directory);
+
+	// запись в журнал не удалась: изменение не применяется к индексу. Права каталога
+	// не мешают root, поэтому сегмент после контрольной точки ведёт на /dev/full
+	const filesystem::path full_device = "/dev/full"s;
+	if (!filesystem::exists(full_device)) {
+		return;
+	}
+	{
+		DurableSearchServer server(directory.string(), "and with"sv);
+		server.AddDocument(1, "cat1 dog1"s, DocumentStatus::ACTUAL, {1});
+		server.AddDocument(2, "cat2 dog2"s, DocumentStatus::ACTUAL, {2});
+		// записи 0 и 1 уже в журнале, поэтому следующий сегмент начнётся с записи 2
+		filesystem::create_symlink(full_device, directory / "wal-00000000000000000002.log"s);
+		server.Checkpoint();
+		for (int id : {3, 4}) {
+			try {
+				server.AddDocument(id, "cat3 dog3"s, DocumentStatus::ACTUAL, {3});
+				ASSERT_HINT(false, "AddDocument must throw when the log fails"s);
+			} catch (const runtime_error&) {
+			}
+		}
+		try {
+			server.RemoveDocument(1);
+			ASSERT_HINT(false, "RemoveDocument must throw when the log fails"s);
+		} catch (const runtime_error&) {
+		}
+		ASSERT_EQUAL(server.GetDocumentCount(), 2);
+		ASSERT(server.FindTopDocuments("cat3"s).empty());
+		ASSERT_EQUAL(server.FindTopDocuments("cat1"s).size(), 1u);
+	}
+	filesystem::remove(directory / "wal-00000000000000000002.log"s);
+	ASSERT_EQUAL(DurableSearchServer(directory.string()).GetDocumentCount(), 2);
+
+	filesystem::remove_all(directory);
+}
+
+void TestLoadDocuments() {
+	const string path = (filesystem::temp_directory_path() / "search_server_test_documents.tsv"s).string();
+	const auto write_file = [&path](const string& content) {
+		ofstream output(path, ios::binary | ios::trunc);
+		output << content;
+	};
+
+	// файл из нескольких кусков, чтобы разбор шёл параллельно
+	SearchServer expected("and with"s);
+	string content;
+	int expected_count = 0;
+	for (int id = 0; content.size() < 3 * LOADER_CHUNK_SIZE; ++id, ++expected_count) {
+		const string text = "cat"s + to_string(id % 10) + " and dog"s + to_string(id % 7) + " parrot"s + to_string(id % 101);
+		const auto status = static_cast<DocumentStatus>(id % 3);
+		content += to_string(id) + "\t"s + (id % 2 == 0 ? to_string(id % 3) : id % 3 == 0 ? "ACTUAL"s : id % 3 == 1
+				? "IRRELEVANT"s : "BANNED"s) + "\t"s + to_string(id % 5) + " "s + to_string(id % 9) + "\t"s + text
+				+ (id % 4 == 0 ? "\r\n"s : "\n"s);
+		expected.AddDocument(id, text, status, {id % 5, id % 9});
+	}
+	content += "\n1000000\t0\t\tcat1 dog1"s;
+	expected.AddDocument(1000000, "cat1 dog1"s, DocumentStatus::ACTUAL, {});
+	++expected_count;
+	write_file(content);
+
+	SearchServer loaded("and with"s);
+	ASSERT_EQUAL(LoadDocuments(loaded, path), static_cast<size_t>(expected_count));
+	ASSERT_EQUAL(loaded.GetDocumentCount(), expected.GetDocumentCount());
+	ASSERT(equal(loaded.begin(), loaded.end(), expected.begin(), expected.end()));
+	for (const string& query : {"cat1 dog2"s, "cat3 -dog4 parrot7"s, "parrot100"s}) {
+		for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED}) {
+			const auto actual_documents = loaded.FindTopDocuments(query, status);
+			const auto expected_documents = expected.FindTopDocuments(query, status);
+			ASSERT_EQUAL(actual_documents.size(), expected_documents.size());
+			for (size_t i = 0; i < expected_documents.size(); ++i) {
+				ASSERT_EQUAL(actual_documents[i].id, expected_documents[i].id);
+				ASSERT_EQUAL(actual_documents[i].rating, expected_documents[i].rating);
+				ASSERT_EQUAL(actual_documents[i].relevance, expected_documents[i].relevance);
+			}
+		}
+	}
+
+	// ошибка сообщает номер строки
+	for (const string& bad_line : {"x\t0\t1\tcat"s, "5\tUNKNOWN\t1\tcat"s, "5\t0\t1 a\tcat"s, "5\t0\tcat"s}) {
+		write_file("1\t0\t1\tcat\n\n"s + bad_line + "\n2\t0\t1\tdog\n"s);
+		SearchServer search_server;
+		try {
+			LoadDocuments(search_server, path);
+			ASSERT_HINT(false, "LoadDocuments must reject "s + bad_line);
+		} catch (const invalid_argument& error) {
+			ASSERT_EQUAL(string(error.what()), "Invalid document at line 3"s);
+		}
+	}
+	write_file(""s);
+	SearchServer empty;
+	ASSERT_EQUAL(LoadDocuments(empty, path), 0u);
+	filesystem::remove(path);
+}
+
+void TestPostingList() {
+	PostingList postings;
+	vector<Posting> expected;
+	// несколько полных блоков и разные длины разностей
+	for (uint32_t ordinal = 3; ordinal < 1000; ordinal += ordinal % 7 + 1) {
+		postings.Append(ordinal * 37, ordinal % 5 + 1, 1.0);
+		expected.push_back({ordinal * 37, ordinal % 5 + 1});
+	}
+	ASSERT_EQUAL(postings.size(), expected.size());
+
+	const auto check_postings = [&postings, &expected]() {
+		vector<Posting> actual;
+		postings.ForEach([&actual](const Posting& posting) { actual.push_back(posting); });
+		ASSERT_EQUAL(actual.size(), expected.size());
+		for (size_t i = 0; i < actual.size(); ++i) {
+			ASSERT_EQUAL(actual[i].ordinal, expected[i].ordinal);
+			ASSERT_EQUAL(actual[i].term_count, expected[i].term_count);
+		}
+	};
+	check_postings();
+
+	ASSERT(postings.Contains(expected[200].ordinal));
+	ASSERT(!postings.Contains(expected[200].ordinal + 1));
+	ASSERT(!postings.Contains(expected.front().ordinal - 1));
+	ASSERT(!postings.Contains(expected.back().ordinal + 1));
+
+	// дозапись продолжает последний неполный блок
+	postings.Append(1'000'000, 42, 1.0);
+	expected.push_back({1'000'000, 42});
+	check_postings();
+	ASSERT(postings.Contains(1'000'000));
+}
+
+void TestScoreAccumulator() {
+	const auto collect = [](const ScoreAccumulator& accumulator) {
+		map<uint32_t, double> scores;
+		accumulator.ForEach([&scores](uint32_t ordinal, double score) {
+			scores[ordinal] = score;
+		});
+		return scores;
+	};
+
+	ScoreAccumulator accumulator;
+	accumulator.Reset(10);
+	accumulator.Add(3, 1.0);
+	accumulator.Add(3, 0.5);
+	accumulator.Add(7, 2.0);
+	accumulator.Reject(5);
+	ASSERT(accumulator.IsAccepted(3));
+	ASSERT(accumulator.IsRejected(5));
+	ASSERT((collect(accumulator) == map<uint32_t, double>{{3, 1.5}, {7, 2.0}}));
+
+	// после сброса оценки и отказы прошлого запроса не видны
+	accumulator.Reset(10);
+	ASSERT(collect(accumulator).empty());
+	ASSERT(!accumulator.IsAccepted(3));
+	ASSERT(!accumulator.IsRejected(5));
+	accumulator.Add(3, 0.25);
+	accumulator.Add(5, 1.0);
+	ASSERT((collect(accumulator) == map<uint32_t, double>{{3, 0.25}, {5, 1.0}}));
+
+	// отказ сильнее сложений до и после него
+	accumulator.Reset(10);
+	accumulator.Add(2, 1.0);
+	accumulator.Reject(2);
+	accumulator.Reject(4);
+	accumulator.Add(4, 1.0);
+	accumulator.Add(2, 1.0);
+	ASSERT(accumulator.IsRejected(2));
+	ASSERT(accumulator.IsRejected(4));
+	ASSERT(collect(accumulator).empty());
+
+	// число номеров выросло между запросами: новые номера чистые, старые сброшены
+	accumulator.Add(9, 3.0);
+	accumulator.Reset(1000);
+	ASSERT(collect(accumulator).empty());
+	accumulator.Add(9, 1.0);
+	accumulator.Add(999, 2.0);
+	accumulator.Add(500, 0.5);
+	ASSERT((collect(accumulator) == map<uint32_t, double>{{9, 1.0}, {500, 0.5}, {999, 2.0}}));
+
+	// меньшее число номеров не теряет уже выделенное место
+	accumulator.Reset(5);
+	ASSERT(collect(accumulator).empty());
+	accumulator.Add(4, 1.0);
+	ASSERT((collect(accumulator) == map<uint32_t, double>{{4, 1.0}}));
+}
+
+void TestFindTopDocumentsMaxCount() {
+	SearchServer server("and with"s);
+	for (int id = 0; id < 20; ++id) {
+		// релевантность убывает с ростом id, у пар документов она одинакова
+		string text = "cat"s;
+		for (int i = 0; i <= id / 2; ++i) {
+			text += " dog"s;
+		}
+		server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+	}
+	for (int id = 20; id < 25; ++id) {
+		server.AddDocument(id, "rat"s, DocumentStatus::ACTUAL, {id});
+	}
+
+	const auto all_docs = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100);
+	ASSERT_EQUAL(all_docs.size(), 20u);
+	for (size_t i = 1; i < all_docs.size(); ++i) {
+		ASSERT(!IsMoreRelevant(all_docs[i], all_docs[i - 1]));
+	}
+
+	ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+	ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0).empty());
+
+	for (const size_t max_count : {1u, 3u, 7u, 19u}) {
+		const auto seq_docs = server.FindTopDocuments(execution::seq, "cat"s, DocumentStatus::ACTUAL, max_count);
+		const auto par_docs = server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::ACTUAL, max_count);
+		ASSERT_EQUAL(seq_docs.size(), max_count);
+		ASSERT_EQUAL(par_docs.size(), max_count);
+		for (size_t i = 0; i < max_count; ++i) {
+			ASSERT_EQUAL(seq_docs[i].id, all_docs[i].id);
+			ASSERT_EQUAL(par_docs[i].id, all_docs[i].id);
+		}
+	}
+}
+
+void TestFindTopDocumentsBlockMaxWand() {
+	mt19937 generator;
+	vector<string> dictionary;
+	for (int i = 0; i < 50; ++i) {
+		dictionary.push_back("w"s + to_string(i));
+	}
+	// частые и редкие слова, чтобы верхние границы блоков различались
+	const auto generate_text = [&generator, &dictionary](int word_count) {
+		string text;
+		for (int i = 0; i < word_count; ++i) {
+			const int max_index = uniform_int_distribution(0, 1)(generator) ? 5 : 49;
+			text += dictionary[uniform_int_distribution(0, max_index)(generator)] + " "s;
+		}
+		return text + "end"s;
+	};
+
+	// документов больше, чем в нескольких окнах перебора, и часть из них удалена
+	SearchServer server("w0"s);
+	const int document_count = static_cast<int>(2 * MAXSCORE_WINDOW_SIZE + 1000);
+	for (int id = 0; id < document_count; ++id) {
+		const auto status = id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+		server.AddDocument(id * 3, generate_text(uniform_int_distribution(1, 30)(generator)), status, {id % 11});
+	}
+	for (int id = 0; id < document_count; id += 13) {
+		server.RemoveDocument(id * 3);
+	}
+
+	const auto check_same_documents = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+		ASSERT_EQUAL(lhs.size(), rhs.size());
+		for (size_t i = 0; i < lhs.size(); ++i) {
+			ASSERT(abs(lhs[i].relevance - rhs[i].relevance) < 1e-6);
+			ASSERT_EQUAL(lhs[i].rating, rhs[i].rating);
+		}
+	};
+
+	// длинные запросы тоже отсекаются, а не перебираются целиком
+	for (int i = 0; i < 100; ++i) {
+		string query = generate_text(uniform_int_distribution(1, 40)(generator));
+		if (i % 3 == 0) {
+			query += " -"s + dictionary[uniform_int_distribution(1, 49)(generator)];
+		}
+		for (const size_t max_count : {1u, 5u, 20u}) {
+			check_same_documents(server.FindTopDocuments(block_max_wand, query, DocumentStatus::ACTUAL, max_count),
+					server.FindTopDocuments(query, DocumentStatus::ACTUAL, max_count));
+			const auto predicate = [](int document_id, DocumentStatus, int rating) {
+				return document_id % 2 == 0 && rating > 3;
+			};
+			check_same_documents(server.FindTopDocuments(block_max_wand, query, predicate, max_count),
+					server.FindTopDocuments(query, predicate, max_count));
+		}
+	}
+	ASSERT(server.FindTopDocuments(block_max_wand, "-end end"s).empty());
+}
+
+void TestFindTopDocumentsParallelMatchesSequential() {
+	mt19937 generator;
+	SearchServer server("and with"s);
+	// документов больше PARALLEL_MIN_SLICE_SIZE, чтобы поиск разбился на несколько отрезков
+	for (int id = 0; id < 5000; ++id) {
+		string text;
+		for (int i = uniform_int_distribution(1, 8)(generator); i > 0; --i) {
+			text += "w"s + to_string(uniform_int_distribution(0, 30)(generator)) + " "s;
+		}
+		server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 13});
+	}
+
+	for (const string& query : {"w1 w2 w3"s, "w4 -w5"s, "w6 w7 -w8 -w9 w10"s, "-w11"s, "w12 unknown -unknown"s}) {
+		for (const size_t max_count : {1u, 5u, 100u}) {
+			const auto seq_docs = server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, max_count);
+			const auto par_docs = server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, max_count);
+			ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+			for (size_t i = 0; i < seq_docs.size(); ++i) {
+				ASSERT(abs(seq_docs[i].relevance - par_docs[i].relevance) < 1e-6);
+				ASSERT_EQUAL(seq_docs[i].rating, par_docs[i].rating);
+			}
+		}
+	}
+
+	// слово есть только в последних документах: отрезки делятся по вхождениям, а не поровну по номерам
+	for (int id = 5000; id < 15000; ++id) {
+		server.AddDocument(id, "tail w"s + to_string(id % 31), DocumentStatus::ACTUAL, {id % 13});
+	}
+	for (const string& query : {"tail"s, "tail w3 -w4"s}) {
+		const auto seq_docs = server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, 50);
+		const auto par_docs = server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, 50);
+		ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+		for (size_t i = 0; i < seq_docs.size(); ++i) {
+			ASSERT(abs(seq_docs[i].relevance - par_docs[i].relevance) < 1e-6);
+			ASSERT_EQUAL(seq_docs[i].rating, par_docs[i].rating);
+		}
+	}
+
+	// документы с минус-словом не попадают в выдачу и в параллельной версии
+	for (const Document& document : server.FindTopDocuments(execution::par, "w4 -w5"s, DocumentStatus::ACTUAL, 100)) {
+		const auto word_freqs = server.GetWordFrequencies(document.id);
+		ASSERT(word_freqs.count("w5"sv) == 0);
+	}
+}
+
 void TestSearchServer()
 {
 	RUN_TEST(TestAddDocument);
@@ -832,10 +2236,33 @@ void TestSearchServer()
 	RUN_TEST(TestRemoveDocument);
 	RUN_TEST(TestRemoveDocument2);
 	RUN_TEST(TestRemoveDocumentWithExecutionPolicy);
+	RUN_TEST(TestAddDocuments);
+	RUN_TEST(TestRemoveDocuments);
+	RUN_TEST(TestRemoveDocumentsCompaction);
+	RUN_TEST(TestDocumentColumnsAfterCompaction);
 	RUN_TEST(TestRemoveDuplicate);
 	RUN_TEST(TestProcessQueries);
 	RUN_TEST(TestProcessQueriesJoined);
 	RUN_TEST(TestFindTopDocumentParrallel);
+	RUN_TEST(TestConcurrentSearchServer);
+	RUN_TEST(TestSegmentedSearchServer);
+	RUN_TEST(TestShardedSearchServer);
+	RUN_TEST(TestThreadPool);
+	RUN_TEST(TestFindTopDocumentsWithDeadline);
+	RUN_TEST(TestFindTopDocumentsBatch);
+	RUN_TEST(TestResultCache);
+	RUN_TEST(TestPreparedQuery);
+	RUN_TEST(TestParseQueryWithoutAllocations);
+	RUN_TEST(TestTokenizeWords);
+	RUN_TEST(TestSnapshot);
+	RUN_TEST(TestMappedSearchServer);
+	RUN_TEST(TestDurableSearchServer);
+	RUN_TEST(TestLoadDocuments);
+	RUN_TEST(TestPostingList);
+	RUN_TEST(TestScoreAccumulator);
+	RUN_TEST(TestFindTopDocumentsMaxCount);
+	RUN_TEST(TestFindTopDocumentsBlockMaxWand);
+	RUN_TEST(TestFindTopDocumentsParallelMatchesSequential);
 }
 
 // --------- Окончание модульных тестов поисковой системы -----------
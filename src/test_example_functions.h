@@ -1,17 +1,33 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <random>
 #include <set>
+#include <thread>
 #include <utility>
 #include <vector>
 
 
+#include "allocation_counter.h"
+#include "concurrent_search_server.h"
 #include "document.h"
+#include "document_loader.h"
+#include "durable_search_server.h"
+#include "mapped_search_server.h"
 #include "print_functions.h"
 #include "process_queries.h"
 #include "remove_duplicates.h"
+#include "request_queue.h"
 #include "search_server.h"
+#include "segmented_search_server.h"
+#include "sharded_search_server.h"
+#include "thread_pool.h"
+#include "tokenizer.h"
 
 
 
@@ -112,10 +128,33 @@ void TestGetWordFrequencies();
 void TestRemoveDocument();
 void TestRemoveDocument2();
 void TestRemoveDocumentWithExecutionPolicy();
+void TestAddDocuments();
+void TestRemoveDocuments();
+void TestRemoveDocumentsCompaction();
+void TestDocumentColumnsAfterCompaction();
 void TestRemoveDuplicate();
 void TestProcessQueries();
 void TestProcessQueriesJoined();
 void TestFindTopDocumentParrallel();
+void TestConcurrentSearchServer();
+void TestSegmentedSearchServer();
+void TestShardedSearchServer();
+void TestThreadPool();
+void TestFindTopDocumentsWithDeadline();
+void TestFindTopDocumentsBatch();
+void TestResultCache();
+void TestPreparedQuery();
+void TestParseQueryWithoutAllocations();
+void TestTokenizeWords();
+void TestSnapshot();
+void TestMappedSearchServer();
+void TestDurableSearchServer();
+void TestLoadDocuments();
+void TestPostingList();
+void TestScoreAccumulator();
+void TestFindTopDocumentsMaxCount();
+void TestFindTopDocumentsBlockMaxWand();
+void TestFindTopDocumentsParallelMatchesSequential();
 
 void TestSearchServer();
 
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker_index = 0;
+
+atomic<size_t> default_worker_count = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t worker_count) {
+	worker_count = max<size_t>(worker_count, 1);
+	for (size_t i = 0; i < worker_count; ++i) {
+		queues_.push_back(make_unique<WorkerQueue>());
+	}
+	for (size_t i = 0; i < worker_count; ++i) {
+		workers_.emplace_back([this, i] { RunWorker(i); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard guard(sleep_mutex_);
+		is_stopping_ = true;
+	}
+	wake_up_.notify_all();
+	for (auto& worker : workers_) {
+		worker.join();
+	}
+}
+
+ThreadPool& ThreadPool::GetDefault() {
+	static ThreadPool pool(default_worker_count > 0 ? default_worker_count.load() : thread::hardware_concurrency());
+	return pool;
+}
+
+void ThreadPool::SetDefaultWorkerCount(size_t worker_count) {
+	default_worker_count = worker_count;
+}
+
+size_t ThreadPool::GetWorkerCount() const {
+	return workers_.size();
+}
+
+void ThreadPool::Push(Task task) {
+	size_t queue_index = GetCurrentWorkerIndex();
+	if (queue_index == queues_.size()) {
+		queue_index = next_queue_++ % queues_.size();
+	}
+	{
+		lock_guard guard(queues_[queue_index]->mutex);
+		queues_[queue_index]->tasks.push_back(move(task));
+	}
+	{
+		// под мьютексом, чтобы засыпающий поток не пропустил пробуждение
+		lock_guard guard(sleep_mutex_);
+		++pending_task_count_;
+	}
+	wake_up_.notify_one();
+}
+
+bool ThreadPool::TryRunTask() {
+	const size_t own_index = GetCurrentWorkerIndex();
+	Task task;
+	if (own_index < queues_.size()) {
+		WorkerQueue& queue = *queues_[own_index];
+		lock_guard guard(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+	}
+	for (size_t i = 1; !task && i <= queues_.size(); ++i) {
+		WorkerQueue& queue = *queues_[(own_index + i) % queues_.size()];
+		lock_guard guard(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+	if (!task) {
+		return false;
+	}
+	--pending_task_count_;
+	task();
+	return true;
+}
+
+void ThreadPool::RunWorker(size_t worker_index) {
+	current_pool = this;
+	current_worker_index = worker_index;
+	while (true) {
+		if (TryRunTask()) {
+			continue;
+		}
+		unique_lock lock(sleep_mutex_);
+		wake_up_.wait(lock, [this] { return is_stopping_ || pending_task_count_ > 0; });
+		if (is_stopping_ && pending_task_count_ == 0) {
+			return;
+		}
+	}
+}
+
+size_t ThreadPool::GetCurrentWorkerIndex() const {
+	return current_pool == this ? current_worker_index : queues_.size();
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Пул потоков с перехватом работы. У каждого рабочего потока своя очередь задач:
+// задачи, поставленные из рабочего потока, попадают в его очередь и выполняются им
+// с конца, а простаивающие потоки забирают задачи из начала чужих очередей.
+// Поток, ожидающий завершения ParallelFor, сам выполняет задачи пула, поэтому
+// вложенные ParallelFor не приводят к взаимной блокировке; когда задач не осталось,
+// он засыпает до завершения помощников, а не крутится в ожидании.
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t worker_count);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Общий пул; им пользуются ProcessQueries и параллельные версии методов SearchServer.
+	// По умолчанию рабочих потоков столько же, сколько ядер.
+	static ThreadPool& GetDefault();
+	// Задаёт число рабочих потоков общего пула; действует только до первого GetDefault
+	static void SetDefaultWorkerCount(size_t worker_count);
+
+	size_t GetWorkerCount() const;
+
+	template <typename Func>
+	std::future<std::invoke_result_t<Func>> Submit(Func func);
+
+	// Вызывает func(index) для каждого index из [0, count). Индексы раздаются по одному,
+	// поэтому задачи разной стоимости распределяются между потоками равномерно.
+	// Первое исключение из func выбрасывается после завершения всех вызовов.
+	template <typename Func>
+	void ParallelFor(size_t count, Func func);
+
+private:
+	using Task = std::function<void()>;
+
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<size_t> next_queue_ = 0;
+	std::atomic<size_t> pending_task_count_ = 0;
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_up_;
+	bool is_stopping_ = false;
+
+	void Push(Task task);
+	// Выполняет одну задачу: свою с конца очереди или чужую с начала
+	bool TryRunTask();
+	void RunWorker(size_t worker_index);
+	// Номер очереди текущего рабочего потока или queues_.size() для посторонних потоков
+	size_t GetCurrentWorkerIndex() const;
+};
+
+template <typename Func>
+std::future<std::invoke_result_t<Func>> ThreadPool::Submit(Func func) {
+	// std::function требует копируемости, поэтому packaged_task хранится в shared_ptr
+	auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Func>()>>(std::move(func));
+	auto result = task->get_future();
+	Push([task] { (*task)(); });
+	return result;
+}
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t count, Func func) {
+	std::atomic<size_t> next_index = 0;
+	std::exception_ptr error;
+	std::mutex error_mutex;
+	size_t finished_helper_count = 0;
+	std::mutex finished_mutex;
+	std::condition_variable helper_finished;
+
+	const auto run = [&] {
+		for (size_t index = next_index++; index < count; index = next_index++) {
+			try {
+				func(index);
+			} catch (...) {
+				std::lock_guard guard(error_mutex);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+	};
+
+	// помощников не больше, чем рабочих потоков; вызывающий поток работает сам
+	const size_t helper_count = std::min(count, workers_.size() + 1) - (count > 0 ? 1 : 0);
+	for (size_t i = 0; i < helper_count; ++i) {
+		Push([&] {
+			run();
+			// уведомление под мьютексом: после его освобождения ParallelFor может вернуться
+			std::lock_guard guard(finished_mutex);
+			++finished_helper_count;
+			helper_finished.notify_one();
+		});
+	}
+	run();
+	// пока в пуле есть задачи, вызывающий поток выполняет их сам. Когда очереди пусты,
+	// все помощники уже выполняются другими потоками, и остаётся только дождаться их
+	while (true) {
+		{
+			std::lock_guard guard(finished_mutex);
+			if (finished_helper_count == helper_count) {
+				break;
+			}
+		}
+		if (!TryRunTask()) {
+			std::unique_lock lock(finished_mutex);
+			helper_finished.wait(lock, [&] { return finished_helper_count == helper_count; });
+			break;
+		}
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TOKENIZER_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "tokenizer.h"
+
+using namespace std;
+
+namespace {
+
+bool IsControl(char c) {
+	return static_cast<unsigned char>(c) < 0x20;
+}
+
+// Дописывает слова, которые заканчиваются пробелами из маски; бит i маски
+// соответствует байту position + i
+void EmitWords(string_view text, size_t position, uint32_t space_mask, size_t& word_begin,
+		vector<string_view>& words) {
+	while (space_mask != 0) {
+		const size_t space = position + __builtin_ctz(space_mask);
+		words.push_back(text.substr(word_begin, space - word_begin));
+		word_begin = space + 1;
+		space_mask &= space_mask - 1;
+	}
+}
+
+// Разбирает байты с position до конца текста и дописывает последнее слово
+size_t FinishTokenize(string_view text, size_t position, size_t word_begin, size_t invalid_position,
+		vector<string_view>& words) {
+	for (; position < text.size(); ++position) {
+		const char c = text[position];
+		if (c == ' ') {
+			words.push_back(text.substr(word_begin, position - word_begin));
+			word_begin = position + 1;
+		} else if (IsControl(c) && invalid_position == string_view::npos) {
+			invalid_position = position;
+		}
+	}
+	words.push_back(text.substr(word_begin));
+	return invalid_position;
+}
+
+size_t TokenizeScalar(string_view text, vector<string_view>& words) {
+	return FinishTokenize(text, 0, 0, string_view::npos, words);
+}
+
+#ifdef TOKENIZER_HAS_X86_SIMD
+
+// SSE2 есть на любом x86-64, поэтому эта версия собирается без особых флагов
+size_t TokenizeSse2(string_view text, vector<string_view>& words) {
+	const __m128i spaces = _mm_set1_epi8(' ');
+	const __m128i max_control = _mm_set1_epi8(0x1F);
+	size_t invalid_position = string_view::npos;
+	size_t word_begin = 0;
+	size_t position = 0;
+	for (; position + 16 <= text.size(); position += 16) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + position));
+		// байт управляющий, если беззнаковый минимум с 0x1F равен ему самому
+		const uint32_t control_mask = static_cast<uint32_t>(
+				_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk)));
+		if (control_mask != 0 && invalid_position == string_view::npos) {
+			invalid_position = position + __builtin_ctz(control_mask);
+		}
+		EmitWords(text, position, static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces))),
+				word_begin, words);
+	}
+	return FinishTokenize(text, position, word_begin, invalid_position, words);
+}
+
+__attribute__((target("avx2")))
+size_t TokenizeAvx2(string_view text, vector<string_view>& words) {
+	const __m256i spaces = _mm256_set1_epi8(' ');
+	const __m256i max_control = _mm256_set1_epi8(0x1F);
+	size_t invalid_position = string_view::npos;
+	size_t word_begin = 0;
+	size_t position = 0;
+	for (; position + 32 <= text.size(); position += 32) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + position));
+		const uint32_t control_mask = static_cast<uint32_t>(
+				_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, max_control), chunk)));
+		if (control_mask != 0 && invalid_position == string_view::npos) {
+			invalid_position = position + __builtin_ctz(control_mask);
+		}
+		EmitWords(text, position, static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, spaces))),
+				word_begin, words);
+	}
+	return FinishTokenize(text, position, word_begin, invalid_position, words);
+}
+
+#endif
+
+using TokenizeFunction = size_t (*)(string_view, vector<string_view>&);
+
+TokenizeFunction GetTokenizeFunction(TokenizerLevel level) {
+	switch (level) {
+#ifdef TOKENIZER_HAS_X86_SIMD
+	case TokenizerLevel::AVX2:
+		return TokenizeAvx2;
+	case TokenizerLevel::SSE2:
+		return TokenizeSse2;
+#endif
+	default:
+		return TokenizeScalar;
+	}
+}
+
+} // namespace
+
+TokenizerLevel GetSupportedTokenizerLevel() {
+#ifdef TOKENIZER_HAS_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return TokenizerLevel::AVX2;
+	}
+	return TokenizerLevel::SSE2;
+#else
+	return TokenizerLevel::SCALAR;
+#endif
+}
+
+size_t TokenizeWords(string_view text, vector<string_view>& words) {
+	static const TokenizeFunction tokenize = GetTokenizeFunction(GetSupportedTokenizerLevel());
+	return tokenize(text, words);
+}
+
+size_t TokenizeWords(string_view text, vector<string_view>& words, TokenizerLevel level) {
+	return GetTokenizeFunction(level)(text, words);
+}
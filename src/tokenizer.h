@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+// Набор инструкций, которым разбирается текст
+enum class TokenizerLevel {
+	SCALAR,
+	SSE2,
+	AVX2,
+};
+
+// Лучший набор инструкций, доступный на этом процессоре
+TokenizerLevel GetSupportedTokenizerLevel();
+
+// За один проход по тексту дописывает в words слова, разделённые пробелами
+// (как SplitIntoWordsView, включая пустые слова между соседними пробелами),
+// и ищет управляющие символы 0x00-0x1F, недопустимые в словах.
+// Возвращает позицию первого недопустимого байта или npos.
+// Набор инструкций выбирается при первом вызове по возможностям процессора.
+size_t TokenizeWords(std::string_view text, std::vector<std::string_view>& words);
+// То же с заданным набором инструкций; он должен поддерживаться процессором
+size_t TokenizeWords(std::string_view text, std::vector<std::string_view>& words, TokenizerLevel level);
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "top_documents_collector.h"
+
+using namespace std;
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+	if (abs(lhs.relevance - rhs.relevance) < 1e-6) {
+		return lhs.rating > rhs.rating;
+	} else {
+		return lhs.relevance > rhs.relevance;
+	}
+}
+
+TopDocumentsCollector::TopDocumentsCollector(size_t max_count)
+: max_count_(max_count)
+{
+	heap_.reserve(max_count_);
+}
+
+void TopDocumentsCollector::Add(const Document& document) {
+	const Candidate candidate{document, sequence_++};
+	if (heap_.size() < max_count_) {
+		heap_.push_back(candidate);
+		push_heap(heap_.begin(), heap_.end(), IsBetter);
+	} else if (max_count_ > 0 && IsBetter(candidate, heap_.front())) {
+		pop_heap(heap_.begin(), heap_.end(), IsBetter);
+		heap_.back() = candidate;
+		push_heap(heap_.begin(), heap_.end(), IsBetter);
+	}
+}
+
+size_t TopDocumentsCollector::GetMaxCount() const {
+	return max_count_;
+}
+
+double TopDocumentsCollector::GetEntryThreshold() const {
+	if (max_count_ == 0) {
+		return numeric_limits<double>::infinity();
+	}
+	if (heap_.size() < max_count_) {
+		return -numeric_limits<double>::infinity();
+	}
+	// более слабый документ может победить только за счёт рейтинга,
+	// если его релевантность отличается меньше чем на 1e-6
+	return heap_.front().document.relevance - 1e-6;
+}
+
+vector<Document> TopDocumentsCollector::Extract() && {
+	sort_heap(heap_.begin(), heap_.end(), IsBetter);
+
+	vector<Document> documents;
+	documents.reserve(heap_.size());
+	for (const auto& candidate : heap_) {
+		documents.push_back(candidate.document);
+	}
+	heap_.clear();
+	return documents;
+}
+
+bool TopDocumentsCollector::IsBetter(const Candidate& lhs, const Candidate& rhs) {
+	if (IsMoreRelevant(lhs.document, rhs.document)) {
+		return true;
+	}
+	if (IsMoreRelevant(rhs.document, lhs.document)) {
+		return false;
+	}
+	return lhs.sequence < rhs.sequence;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "document.h"
+
+// Порядок выдачи: по убыванию релевантности, при равной (с точностью 1e-6)
+// релевантности - по убыванию рейтинга
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+// Отбирает max_count лучших документов, не сортируя все найденные.
+// Хранит кучу размера не более max_count, в вершине которой худший из отобранных.
+// Из равных документов выигрывает тот, что был добавлен раньше.
+class TopDocumentsCollector {
+public:
+	explicit TopDocumentsCollector(size_t max_count);
+
+	void Add(const Document& document);
+
+	size_t GetMaxCount() const;
+
+	// Документ с релевантностью не больше порога в выдачу уже не попадёт.
+	// Пока отобрано меньше max_count документов, порог равен минус бесконечности.
+	double GetEntryThreshold() const;
+
+	// Отобранные документы в порядке выдачи
+	std::vector<Document> Extract() &&;
+
+private:
+	struct Candidate {
+		Document document;
+		size_t sequence;
+	};
+
+	static bool IsBetter(const Candidate& lhs, const Candidate& rhs);
+
+	size_t max_count_;
+	size_t sequence_ = 0;
+	std::vector<Candidate> heap_;
+};
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "binary_io.h"
+#include "write_ahead_log.h"
+
+using namespace std;
+
+namespace {
+
+// Заголовок записи; за ним следуют номер записи и её содержимое, size - их общая длина
+struct RecordHeader {
+	uint32_t size;
+	uint32_t reserved;
+	uint64_t checksum;
+};
+
+const string SEGMENT_PREFIX = "wal-"s;
+const string SEGMENT_SUFFIX = ".log"s;
+
+string GetSegmentPath(const string& directory, uint64_t first_lsn) {
+	char name[32];
+	// номер дополняется нулями, чтобы имена сегментов сортировались как номера
+	snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(first_lsn));
+	return (filesystem::path(directory) / (SEGMENT_PREFIX + name + SEGMENT_SUFFIX)).string();
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const string& directory, uint64_t next_lsn)
+: directory_(directory)
+, next_lsn_(next_lsn)
+, synced_lsn_(next_lsn)
+{
+	filesystem::create_directories(directory_);
+	OpenSegment();
+}
+
+uint64_t WriteAheadLog::Append(string_view record) {
+	lock_guard guard(mutex_);
+	if (is_failed_) {
+		throw runtime_error("Write-ahead log in "s + directory_ + " failed"s);
+	}
+	const uint64_t lsn = next_lsn_++;
+	RecordHeader header{static_cast<uint32_t>(sizeof(lsn) + record.size()), 0, 0};
+	const size_t header_position = buffer_.size();
+	buffer_.append(sizeof(header), '\0');
+	buffer_.append(reinterpret_cast<const char*>(&lsn), sizeof(lsn));
+	buffer_.append(record);
+	header.checksum = ComputeChecksum(string_view(buffer_).substr(header_position + sizeof(header)));
+	memcpy(buffer_.data() + header_position, &header, sizeof(header));
+	return lsn;
+}
+
+void WriteAheadLog::Sync(uint64_t lsn) {
+	unique_lock lock(mutex_);
+	while (synced_lsn_ <= lsn) {
+		if (is_failed_) {
+			throw runtime_error("Write-ahead log in "s + directory_ + " failed"s);
+		}
+		if (is_syncing_) {
+			synced_.wait(lock);
+			continue;
+		}
+		// этот поток сбрасывает записи всех, кто успел их добавить
+		is_syncing_ = true;
+		const string batch = move(buffer_);
+		buffer_.clear();
+		const uint64_t batch_end = next_lsn_;
+		lock.unlock();
+		try {
+			segment_->Append(batch);
+			segment_->Sync();
+		} catch (...) {
+			lock.lock();
+			is_syncing_ = false;
+			is_failed_ = true;
+			synced_.notify_all();
+			throw;
+		}
+		lock.lock();
+		is_syncing_ = false;
+		synced_lsn_ = batch_end;
+		synced_.notify_all();
+	}
+}
+
+uint64_t WriteAheadLog::Rotate() {
+	unique_lock lock(mutex_);
+	synced_.wait(lock, [this] {
+		return !is_syncing_;
+	});
+	if (is_failed_) {
+		throw runtime_error("Write-ahead log in "s + directory_ + " failed"s);
+	}
+	segment_->Append(buffer_);
+	segment_->Sync();
+	buffer_.clear();
+	synced_lsn_ = next_lsn_;
+	synced_.notify_all();
+	OpenSegment();
+	return next_lsn_;
+}
+
+void WriteAheadLog::RemoveSegmentsBefore(uint64_t lsn) {
+	const auto segments = ListSegments(directory_);
+	// записи сегмента заканчиваются там, где начинается следующий
+	for (size_t i = 0; i + 1 < segments.size() && segments[i + 1].first <= lsn; ++i) {
+		filesystem::remove(segments[i].second);
+	}
+	SyncDirectory(directory_);
+}
+
+uint64_t WriteAheadLog::Replay(const string& directory, uint64_t first_lsn, const RecordHandler& handler) {
+	const auto segments = ListSegments(directory);
+	size_t segment_index = 0;
+	while (segment_index + 1 < segments.size() && segments[segment_index + 1].first <= first_lsn) {
+		++segment_index;
+	}
+	if (segment_index == segments.size()) {
+		return first_lsn;
+	}
+
+	uint64_t next_lsn = segments[segment_index].first;
+	if (next_lsn > first_lsn) {
+		throw runtime_error("Write-ahead log in "s + directory + " misses records"s);
+	}
+	for (; segment_index < segments.size(); ++segment_index) {
+		const auto& [segment_lsn, path] = segments[segment_index];
+		if (segment_lsn != next_lsn) {
+			throw runtime_error("Write-ahead log in "s + directory + " misses records"s);
+		}
+		string data;
+		{
+			ifstream input(path, ios::binary);
+			data.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+		}
+
+		size_t position = 0;
+		while (position < data.size()) {
+			RecordHeader header;
+			const size_t available = data.size() - position;
+			bool is_valid = available >= sizeof(header);
+			if (is_valid) {
+				memcpy(&header, data.data() + position, sizeof(header));
+				is_valid = header.size >= sizeof(uint64_t) && header.size <= available - sizeof(header)
+						&& ComputeChecksum(string_view(data).substr(position + sizeof(header), header.size))
+								== header.checksum;
+			}
+			if (!is_valid) {
+				// недописанной может быть только последняя запись последнего сегмента
+				if (segment_index + 1 != segments.size()) {
+					throw runtime_error("Write-ahead log segment "s + path + " is corrupted"s);
+				}
+				filesystem::resize_file(path, position);
+				break;
+			}
+			uint64_t lsn;
+			memcpy(&lsn, data.data() + position + sizeof(header), sizeof(lsn));
+			if (lsn != next_lsn) {
+				throw runtime_error("Write-ahead log segment "s + path + " is corrupted"s);
+			}
+			if (lsn >= first_lsn) {
+				handler(lsn, string_view(data).substr(position + sizeof(header) + sizeof(lsn),
+						header.size - sizeof(lsn)));
+			}
+			++next_lsn;
+			position += sizeof(header) + header.size;
+		}
+	}
+	if (next_lsn < first_lsn) {
+		throw runtime_error("Write-ahead log in "s + directory + " misses records"s);
+	}
+	return next_lsn;
+}
+
+void WriteAheadLog::OpenSegment() {
+	segment_ = make_unique<AppendOnlyFile>(GetSegmentPath(directory_, next_lsn_), true);
+	SyncDirectory(directory_);
+}
+
+vector<pair<uint64_t, string>> WriteAheadLog::ListSegments(const string& directory) {
+	vector<pair<uint64_t, string>> segments;
+	if (!filesystem::exists(directory)) {
+		return segments;
+	}
+	for (const auto& entry : filesystem::directory_iterator(directory)) {
+		const string name = entry.path().filename().string();
+		if (name.size() > SEGMENT_PREFIX.size() + SEGMENT_SUFFIX.size()
+				&& name.compare(0, SEGMENT_PREFIX.size(), SEGMENT_PREFIX) == 0
+				&& name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX) == 0) {
+			const string number = name.substr(SEGMENT_PREFIX.size(),
+					name.size() - SEGMENT_PREFIX.size() - SEGMENT_SUFFIX.size());
+			segments.emplace_back(stoull(number), entry.path().string());
+		}
+	}
+	sort(segments.begin(), segments.end());
+	return segments;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "file_io.h"
+
+// Журнал упреждающей записи: записи с последовательными номерами (LSN) в файлах-
+// сегментах одного каталога. Сегмент называется по номеру своей первой записи.
+// Каждая запись хранит длину и контрольную сумму, поэтому недописанный при сбое
+// хвост распознаётся при чтении и отбрасывается.
+//
+// Групповая фиксация: Append только кладёт запись в буфер, а Sync ждёт, пока она
+// окажется на диске. Первый из ожидающих потоков записывает весь накопленный буфер
+// и вызывает fsync, остальные ждут его, поэтому одновременные писатели делят один fsync.
+class WriteAheadLog {
+public:
+	using RecordHandler = std::function<void(uint64_t lsn, std::string_view record)>;
+
+	// Начинает в каталоге новый сегмент; первая запись получит номер next_lsn
+	WriteAheadLog(const std::string& directory, uint64_t next_lsn);
+
+	// Добавляет запись в буфер и возвращает её номер; потокобезопасен
+	uint64_t Append(std::string_view record);
+	// Возвращает, когда записи с номерами до lsn включительно сброшены на диск
+	void Sync(uint64_t lsn);
+
+	// Сбрасывает записи на диск и начинает новый сегмент; возвращает номер его первой записи
+	uint64_t Rotate();
+	// Удаляет сегменты, все записи которых имеют номера меньше lsn
+	void RemoveSegmentsBefore(uint64_t lsn);
+
+	// Передаёт handler записи каталога с номерами от first_lsn по порядку и
+	// возвращает номер, следующий за последней записью. Недописанный хвост
+	// последнего сегмента обрезается; повреждение в другом месте и пропуск
+	// номеров приводят к runtime_error.
+	static uint64_t Replay(const std::string& directory, uint64_t first_lsn, const RecordHandler& handler);
+
+private:
+	std::string directory_;
+	std::unique_ptr<AppendOnlyFile> segment_;
+
+	std::mutex mutex_;
+	std::condition_variable synced_;
+	// закодированные записи, ещё не переданные в файл
+	std::string buffer_;
+	uint64_t next_lsn_;
+	// записи с номерами меньше synced_lsn_ уже на диске
+	uint64_t synced_lsn_;
+	bool is_syncing_ = false;
+	// после ошибки записи журнал не принимает новых записей
+	bool is_failed_ = false;
+
+	void OpenSegment();
+
+	// Номера первых записей и пути сегментов каталога по возрастанию номеров
+	static std::vector<std::pair<uint64_t, std::string>> ListSegments(const std::string& directory);
+};